@@ -0,0 +1,50 @@
+// Sample RFM69 sketch comparing blocking send() against the non-blocking startSend()
+// For every frame it prints how long send() kept the CPU busy and how many loop passes
+// the sketch got through while startSend() had the same frame on air
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <SPI.h>
+
+#define NODEID        2    //unique for each node on same network
+#define NETWORKID     100  //the same on all nodes that talk to each other
+#define GATEWAYID     1
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+//#define FREQUENCY     RF69_915MHZ
+//#define IS_RFM69HW    //uncomment only for RFM69HW! Leave out if you have RFM69W!
+#define SERIAL_BAUD   115200
+
+char payload[] = "123 ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+RFM69 radio;
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW
+  radio.setHighPower(); //uncomment only for RFM69HW!
+#endif
+  Serial.println("\nblocking ms / async ms / loop passes during async TX");
+}
+
+void loop() {
+  unsigned long start = millis();
+  radio.send(GATEWAYID, payload, sizeof(payload));
+  unsigned long blockingTime = millis() - start;
+
+  while (!radio.startSend(GATEWAYID, payload, sizeof(payload)));
+  start = millis();
+  unsigned long passes = 0;
+  while (!radio.sendDone())
+    passes++; //stands in for servicing serial/sensors while the frame is on air
+  unsigned long asyncTime = millis() - start;
+
+  Serial.print(blockingTime);
+  Serial.print(" / ");
+  Serial.print(asyncTime);
+  Serial.print(" / ");
+  Serial.println(passes);
+  delay(1000);
+}
@@ -0,0 +1,78 @@
+// Sample RFM69 sketch measuring bulk throughput: the same 2KB blob is sent with the windowed
+// sendBulk() and then as separate sendWithRetry() frames, each waiting for its own ACK
+// Flash it on two Moteinos, one with RECEIVER defined
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <SPI.h>
+
+//#define RECEIVER           //uncomment on the receiving node
+#ifdef RECEIVER
+#define NODEID        1
+#define PEERID        2
+#else
+#define NODEID        2
+#define PEERID        1
+#endif
+#define NETWORKID     100  //the same on all nodes that talk to each other
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+//#define FREQUENCY     RF69_915MHZ
+//#define IS_RFM69HW    //uncomment only for RFM69HW! Leave out if you have RFM69W!
+#define SERIAL_BAUD   115200
+#define BLOB_SIZE     2048
+
+byte blob[BLOB_SIZE];
+RFM69 radio;
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW
+  radio.setHighPower(); //uncomment only for RFM69HW!
+#endif
+#ifdef RECEIVER
+  radio.setBulkBuffer(blob, sizeof(blob));
+  Serial.println("\nwaiting for transfers");
+#else
+  for (word i = 0; i < sizeof(blob); i++)
+    blob[i] = i;
+  Serial.println("\nsendBulk B/s / sendWithRetry B/s");
+#endif
+}
+
+#ifdef RECEIVER
+void loop() {
+  if (radio.receiveDone() && radio.ACK_REQUESTED) //per frame path
+    radio.sendACK();
+  word size = radio.bulkReceived(); //block path, frames are collected inside receiveDone()
+  if (size)
+  {
+    Serial.print(size);
+    Serial.print(" bytes from ");
+    Serial.println(radio.bulkSender());
+  }
+}
+#else
+void loop() {
+  unsigned long start = millis();
+  bool ok = radio.sendBulk(PEERID, blob, sizeof(blob));
+  unsigned long bulkTime = millis() - start;
+
+  start = millis();
+  for (word i = 0; ok && i < sizeof(blob); i += MAX_DATA_LEN)
+    ok = radio.sendWithRetry(PEERID, blob + i, sizeof(blob) - i < MAX_DATA_LEN ? sizeof(blob) - i : MAX_DATA_LEN);
+  unsigned long frameTime = millis() - start;
+
+  if (ok)
+  {
+    Serial.print(sizeof(blob) * 1000UL / (bulkTime ? bulkTime : 1));
+    Serial.print(" / ");
+    Serial.println(sizeof(blob) * 1000UL / (frameTime ? frameTime : 1));
+  }
+  else Serial.println("transfer failed");
+  delay(2000);
+}
+#endif
@@ -0,0 +1,89 @@
+// Benchmark for the RFM69 payload compression (radio.setCompression(), needs RF69_COMPRESSION 1 in RFM69.h)
+// No radio needed: for a few typical payloads it prints the compressed size, the bytes on air
+// with and without compression and how long compressing and expanding take on this MCU.
+// Payloads that don't get shorter go out as they are, so they only cost the compressor's time
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <RFM69lz.h>
+#include <SPI.h>
+
+#define SERIAL_BAUD   115200
+#define OVERHEAD      6    //length, target, sender, control byte and the radio's CRC: never compressed
+#define RUNS          100  //timing runs
+
+typedef struct { //as sent by the Struct_send example
+  int           nodeId;
+  unsigned long uptime;
+  float         temp;
+} Payload;
+
+byte data[MAX_DATA_LEN];
+byte packed[MAX_DATA_LEN];
+byte expanded[MAX_DATA_LEN];
+uint32_t rnd = 0x2545F491;
+
+uint32_t random32() {
+  rnd ^= rnd << 13;
+  rnd ^= rnd >> 17;
+  rnd ^= rnd << 5;
+  return rnd;
+}
+
+void bench(const char* name, byte len) {
+  byte size = 0;
+  unsigned long start = micros();
+  for (byte i = 0; i < RUNS; i++)
+    size = lzCompress(packed, data, len);
+  unsigned long compressTime = micros() - start;
+  unsigned long expandTime = 0;
+  if (size)
+  {
+    start = micros();
+    for (byte i = 0; i < RUNS; i++)
+      lzExpand(expanded, sizeof(expanded), packed, size);
+    expandTime = micros() - start;
+    if (memcmp(expanded, data, len))
+      Serial.print("MISMATCH ");
+  }
+  Serial.print(name);
+  Serial.print("   "); Serial.print(len);
+  Serial.print(" -> "); Serial.print(size ? size : len);
+  Serial.print("   "); Serial.print(OVERHEAD + len); Serial.print(" / "); Serial.print(OVERHEAD + (size ? size : len));
+  Serial.print("   "); Serial.print((float)compressTime / RUNS); Serial.print(" / "); Serial.print((float)compressTime / RUNS * (F_CPU / 1000000UL), 0);
+  Serial.print("   "); Serial.print((float)expandTime / RUNS); Serial.print(" / "); Serial.println((float)expandTime / RUNS * (F_CPU / 1000000UL), 0);
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  Serial.println("\npayload   bytes -> compressed   on air plain / compressed   compress us / cycles   expand us / cycles");
+
+  sprintf((char*)data, "FLASH_MEM_ID:0x%X", 0xEF30); //Node example
+  bench("flash id", strlen((char*)data));
+
+  strcpy((char*)data, "123 ABCDEFGHIJKLMNOPQRSTUVWXYZ"); //Node example
+  bench("node    ", strlen((char*)data));
+
+  sprintf((char*)data, " temp:%d.%d hum:%d.%d bat:%d.%02d rssi:%d", 21, 5, 48, 2, 3, 71, -67);
+  bench("text    ", strlen((char*)data));
+
+  Payload p = { 2, 123456, 21.5 }; //Struct_send example
+  memcpy(data, &p, sizeof(p));
+  bench("struct  ", sizeof(p));
+
+  for (byte i = 0; i < MAX_DATA_LEN / sizeof(p); i++) //a batch of readings sent together
+  {
+    p.uptime += 5000;
+    p.temp += 0.25;
+    memcpy(data + i * sizeof(p), &p, sizeof(p));
+  }
+  bench("structs ", MAX_DATA_LEN / sizeof(p) * sizeof(p));
+
+  for (byte i = 0; i < MAX_DATA_LEN; i++)
+    data[i] = random32();
+  bench("random  ", MAX_DATA_LEN);
+}
+
+void loop() {
+}
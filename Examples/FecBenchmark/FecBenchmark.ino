@@ -0,0 +1,103 @@
+// Benchmark for the RFM69 forward error correction (radio.setFec(), needs RF69_FEC 1 in RFM69.h)
+// No radio needed: it times encoding and decoding a full frame on this MCU, then pushes frames
+// through a channel with random bit errors and prints, for each bit error rate, how many frames
+// get through with and without FEC and the resulting goodput in payload bytes per byte on air
+// The channel model also runs on the host with the library's tests (test/test_fec.cpp, make -C test)
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <RFM69fec.h>
+#include <SPI.h>
+
+#define SERIAL_BAUD   115200
+#define PAYLOAD       (MAX_DATA_LEN / 2 - RF69_FEC_CRC_LEN) //the most a FIFO sized frame carries with FEC
+#define CODED         RF69_FEC_CODED_LEN(PAYLOAD)
+#define HEADER        4    //length, target, sender, control byte: never coded
+#define RUNS          200  //timing runs
+#define FRAMES        300  //frames per bit error rate
+
+const float BER[] = { 0.0001, 0.0003, 0.001, 0.003, 0.01, 0.02 };
+byte data[PAYLOAD];
+byte code[CODED];
+byte decoded[CODED / 2];
+uint32_t rnd = 0x2545F491;
+
+uint32_t random32() {
+  rnd ^= rnd << 13;
+  rnd ^= rnd >> 17;
+  rnd ^= rnd << 5;
+  return rnd;
+}
+
+//flips each of bits bits with probability threshold / 2^32, returns how many were flipped
+word addErrors(byte* buf, word bits, uint32_t threshold) {
+  word flipped = 0;
+  for (word i = 0; i < bits; i++)
+    if (random32() < threshold)
+    {
+      if (buf) buf[i >> 3] ^= 1 << (i & 7);
+      flipped++;
+    }
+  return flipped;
+}
+
+void encodeFrame() {
+  word crc = fecCrc(0xFFFF, data, PAYLOAD);
+  byte trailer[RF69_FEC_CRC_LEN] = { (byte)(crc >> 8), (byte)crc };
+  fecEncode(fecEncode(code, data, PAYLOAD), trailer, RF69_FEC_CRC_LEN);
+  fecInterleave(code, CODED);
+}
+
+bool decodeFrame() {
+  fecInterleave(code, CODED);
+  if (fecDecode(decoded, code, CODED) < 0)
+    return false;
+  word crc = fecCrc(0xFFFF, decoded, PAYLOAD);
+  return decoded[PAYLOAD] == (byte)(crc >> 8) && decoded[PAYLOAD + 1] == (byte)crc;
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  for (byte i = 0; i < PAYLOAD; i++)
+    data[i] = random32();
+
+  unsigned long start = micros();
+  for (word i = 0; i < RUNS; i++)
+    encodeFrame();
+  unsigned long encodeTime = micros() - start;
+  start = micros();
+  for (word i = 0; i < RUNS; i++)
+  {
+    fecInterleave(code, CODED); //decodeFrame() undoes it again
+    decodeFrame();
+  }
+  unsigned long decodeTime = micros() - start;
+  Serial.print("\n"); Serial.print(PAYLOAD); Serial.print(" byte payload, "); Serial.print(CODED); Serial.println(" bytes coded");
+  Serial.print("encode us / cycles: "); Serial.print((float)encodeTime / RUNS); Serial.print(" / "); Serial.println((float)encodeTime / RUNS * (F_CPU / 1000000UL));
+  Serial.print("decode us / cycles: "); Serial.print((float)decodeTime / RUNS); Serial.print(" / "); Serial.println((float)decodeTime / RUNS * (F_CPU / 1000000UL));
+
+  //plain frames carry the payload and the radio's 2 byte CRC, any bit error loses the frame
+  Serial.println("\nBER      plain%  fec%   plain goodput  fec goodput");
+  for (byte b = 0; b < sizeof(BER) / sizeof(BER[0]); b++)
+  {
+    uint32_t threshold = BER[b] * 4294967296.0;
+    word plainOk = 0, fecOk = 0;
+    for (word f = 0; f < FRAMES; f++)
+    {
+      if (!addErrors(null, (HEADER + PAYLOAD + 2) * 8, threshold))
+        plainOk++;
+      encodeFrame();
+      if (!addErrors(null, HEADER * 8, threshold) && (addErrors(code, CODED * 8, threshold), decodeFrame()))
+        fecOk++;
+    }
+    Serial.print(BER[b], 4);
+    Serial.print("   "); Serial.print(100.0 * plainOk / FRAMES, 1);
+    Serial.print("   "); Serial.print(100.0 * fecOk / FRAMES, 1);
+    Serial.print("   "); Serial.print((float)plainOk * PAYLOAD / FRAMES / (HEADER + PAYLOAD + 2), 3);
+    Serial.print("          "); Serial.println((float)fecOk * PAYLOAD / FRAMES / (HEADER + CODED), 3);
+  }
+}
+
+void loop() {
+}
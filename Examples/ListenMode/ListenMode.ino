@@ -0,0 +1,71 @@
+// Sample RFM69 sketch for listen mode wake-up
+// The node with LISTENER defined stays in listen mode and answers every burst it hears
+// once the burst is over; the other node sends a burst every few seconds and prints
+// how long it took from the start of the burst until the answer came back
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <SPI.h>
+
+//#define LISTENER            //uncomment on the node that listens
+#define NETWORKID     100  //the same on all nodes that talk to each other
+#ifdef LISTENER
+  #define NODEID      2
+  #define PEERID      1
+#else
+  #define NODEID      1
+  #define PEERID      2
+#endif
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+//#define FREQUENCY     RF69_915MHZ
+//#define IS_RFM69HW    //uncomment only for RFM69HW! Leave out if you have RFM69W!
+#define SERIAL_BAUD   115200
+
+RFM69 radio;
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW
+  radio.setHighPower(); //uncomment only for RFM69HW!
+#endif
+  uint32_t rxDuration, idleDuration;
+  radio.listenModeGetDurations(rxDuration, idleDuration); //both nodes must use the same durations
+  Serial.print("\nRX us / idle us: ");
+  Serial.print(rxDuration);
+  Serial.print(" / ");
+  Serial.println(idleDuration);
+#ifdef LISTENER
+  radio.listenModeStart();
+#endif
+}
+
+#ifdef LISTENER
+void loop() {
+  if (radio.receiveDone())
+  {
+    delay(radio.getBurstRemaining()); //the sender is deaf until its burst is over
+    radio.send(PEERID, "awake", 5);
+    radio.listenModeStart();
+  }
+}
+#else
+void loop() {
+  unsigned long start = millis();
+  radio.listenModeSendBurst(PEERID, "wake", 4);
+  unsigned long burstTime = millis() - start;
+  bool answered = false;
+  while (!(answered = radio.receiveDone()) && millis() - start < burstTime + 500);
+  Serial.print("burst ms / answer after ms: ");
+  Serial.print(burstTime);
+  Serial.print(" / ");
+  if (answered)
+    Serial.println(millis() - start);
+  else
+    Serial.println("-");
+  delay(5000);
+}
+#endif
@@ -0,0 +1,78 @@
+// Sample RFM69 sketch sending messages longer than a frame: the sender builds a log record of a
+// few hundred bytes and sendMessage() cuts it into fragments, the receiver gets it back in one
+// piece from messageReceived() and prints it
+// Flash it on two Moteinos, one with RECEIVER defined
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <SPI.h>
+
+//#define RECEIVER           //uncomment on the receiving node
+#ifdef RECEIVER
+#define NODEID        1
+#define PEERID        2
+#else
+#define NODEID        2
+#define PEERID        1
+#endif
+#define NETWORKID     100  //the same on all nodes that talk to each other
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+//#define FREQUENCY     RF69_915MHZ
+//#define IS_RFM69HW    //uncomment only for RFM69HW! Leave out if you have RFM69W!
+#define SERIAL_BAUD   115200
+#define POOL_SIZE     (RF69_FRAG_SLOTS * 384) //messages up to 384 bytes
+
+RFM69 radio;
+#ifdef RECEIVER
+byte pool[POOL_SIZE];
+#else
+char record[384];
+word records = 0;
+#endif
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW
+  radio.setHighPower(); //uncomment only for RFM69HW!
+#endif
+#ifdef RECEIVER
+  radio.setMessageBuffer(pool, sizeof(pool));
+  Serial.println("\nwaiting for messages");
+#endif
+}
+
+#ifdef RECEIVER
+void loop() {
+  if (radio.receiveDone() && radio.ACK_REQUESTED) //fragments are taken and ACKed inside receiveDone()
+    radio.sendACK();
+  word size = radio.messageReceived();
+  if (size)
+  {
+    Serial.print(size);
+    Serial.print(" bytes from ");
+    Serial.print(radio.messageSender());
+    Serial.print(": ");
+    const byte* data = radio.messageData();
+    for (word i = 0; i < size; i++)
+      Serial.print((char)data[i]);
+    Serial.println();
+  }
+}
+#else
+void loop() {
+  word len = 0;
+  records++;
+  while (len < sizeof(record) - 40) //stands in for a log record or configuration blob
+    len += sprintf(record + len, "rec %u t=%lu vcc=%d;", records, millis(), 3300 - (int)(len % 97));
+  unsigned long start = millis();
+  bool ok = radio.sendMessage(PEERID, record, len);
+  Serial.print(len);
+  Serial.print(ok ? " bytes sent in ms: " : " bytes failed after ms: ");
+  Serial.println(millis() - start);
+  delay(3000);
+}
+#endif
@@ -0,0 +1,73 @@
+// Benchmark for the RFM69 AES-CCM link security (radio.setSecurity(), needs RF69_SECURITY 1 in RFM69.h)
+// No radio needed: it counts the CPU cycles one AES block and sealing/opening a frame take with
+// the software AES and, where the port has one (HAVE_AES_ENGINE, the EFM32 AES peripheral),
+// with the hardware. Receivers open frames in receiveDone()/popFrame(), not the ISR, so the open
+// figure is what each secured frame adds to those calls; the ISR only moves it out of the FIFO
+// Library and code by Felix Rusu - felix@lowpowerlab.com
+// Get the RFM69 and SPIFlash library at: https://github.com/LowPowerLab/
+
+#include <RFM69.h>
+#include <RFM69ccm.h>
+#include <SPI.h>
+
+#define SERIAL_BAUD   115200
+#define RUNS          50   //timing runs
+#define SHORT         10   //a small sensor reading
+#define FULL          (MAX_DATA_LEN - RF69_SECURITY_OVERHEAD) //the most a FIFO sized frame carries secured
+
+#ifdef HAVE_CYCLE_COUNTER
+#define CYCLES()      cycleCount()
+#else
+#define CYCLES()      ((uint32_t)(micros() * (F_CPU / 1000000UL))) //as fine as micros() gets, 4us on a 16MHz AVR
+#endif
+
+const byte key[16] = { 's','a','m','p','l','e','E','n','c','r','y','p','t','K','e','y' };
+const byte header[3] = { 1, 2, 0x40 };
+byte nonce[RF69_CCM_NONCE_LEN];
+byte data[FULL];
+byte mic[RF69_CCM_MIC_LEN];
+
+void bench(const char* name, RFM69Cipher cipher) {
+  byte block[16] = { 0 };
+  uint32_t start = CYCLES();
+  for (byte i = 0; i < RUNS; i++)
+    cipher(block, key);
+  uint32_t blockCycles = (CYCLES() - start) / RUNS;
+  Serial.print(name);
+  Serial.print("   "); Serial.print(blockCycles);
+  byte sizes[2] = { SHORT, FULL };
+  for (byte s = 0; s < 2; s++)
+  {
+    start = CYCLES();
+    for (byte i = 0; i < RUNS; i++)
+      ccmSeal(cipher, key, nonce, header, 3, data, sizes[s], mic);
+    uint32_t sealCycles = (CYCLES() - start) / RUNS;
+    bool ok = true;
+    start = CYCLES();
+    for (byte i = 0; i < RUNS; i++)
+    {
+      ccmSeal(cipher, key, nonce, header, 3, data, sizes[s], mic); //opening decrypts in place
+      ok &= ccmOpen(cipher, key, nonce, header, 3, data, sizes[s], mic);
+    }
+    uint32_t openCycles = (CYCLES() - start) / RUNS - sealCycles;
+    Serial.print("   "); Serial.print(sealCycles); Serial.print(" / "); Serial.print(openCycles);
+    if (!ok) Serial.print(" FAILED");
+  }
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  for (byte i = 0; i < FULL; i++)
+    data[i] = i;
+  nonce[0] = 2;
+  Serial.print("\ncycles: AES block, seal / open "); Serial.print(SHORT);
+  Serial.print(" bytes, seal / open "); Serial.print(FULL); Serial.println(" bytes");
+  bench("software", aesEncrypt);
+#ifdef HAVE_AES_ENGINE
+  bench("hardware", aesEngineEncrypt);
+#endif
+}
+
+void loop() {
+}
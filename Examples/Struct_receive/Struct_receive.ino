@@ -28,6 +28,8 @@ void setup() {
   //radio.setHighPower(); //uncomment only for RFM69HW!
   radio.encrypt(KEY);
   radio.promiscuous(promiscuousMode);
+  radio.setReceiveBuffer(&theData, sizeof(theData)); //payloads land in theData, no copy out of radio.DATA
+                                                     //any frame overwrites it, even a short or foreign one: only trust it after the DATALEN check
   char buff[50];
   sprintf(buff, "\nListening at %d Mhz...", FREQUENCY==RF69_433MHZ ? 433 : FREQUENCY==RF69_868MHZ ? 868 : 915);
   Serial.println(buff);
@@ -96,7 +98,6 @@ void loop() {
       Serial.print("Invalid payload received, not matching Payload struct!");
     else
     {
-      theData = *(Payload*)radio.DATA; //assume radio.DATA actually contains our struct and not something else
       Serial.print(" nodeId=");
       Serial.print(theData.nodeId);
       Serial.print(" uptime=");
@@ -8,21 +8,34 @@
 // **********************************************************************************
 #include <RFM69.h>
 #include <RFM69registers.h>
+#include <RFM69fec.h>
+#include <RFM69lz.h>
+#include <RFM69ccm.h>
 #include <SPI.h>
 
 #define  RF_BITRATEMSB_CUSTOM  0x2e
 #define  RF_BITRATELSB_CUSTOM  0x66
 
-volatile byte RFM69::DATA[MAX_DATA_LEN];
-volatile byte RFM69::_mode;       // current transceiver state
-volatile byte RFM69::DATALEN;
-volatile byte RFM69::SENDERID;
-volatile byte RFM69::TARGETID; //should match _address
-volatile byte RFM69::PAYLOADLEN;
-volatile byte RFM69::ACK_REQUESTED;
-volatile byte RFM69::ACK_RECEIVED; /// Should be polled immediately after sending a packet with ACK request
-volatile int RFM69::RSSI; //most accurate RSSI during reception (closest to the reception)
-RFM69* RFM69::selfPointer;
+RFM69* RFM69::_irqOwner[RF69_MAX_IRQ];
+
+// Frame timestamps: where the core can latch the DIO0 edge in a timer capture channel the stamp is
+// exact, otherwise it is taken on entry to the ISR and carries the interrupt latency
+#ifdef HAVE_INPUT_CAPTURE
+#define timestampEdge(interruptNum) captureRead(interruptNum)
+#define timestampNow() captureNow()
+#define TIMESTAMP_RATE captureTicksPerSecond()
+#else
+#define timestampEdge(interruptNum) micros()
+#define timestampNow() micros()
+#define TIMESTAMP_RATE 1000000UL
+#endif
+
+// registers up to REG_SHADOW_LAST whose content only changes when written by us, one bit per address
+// (left out: FIFO, OSC1, LNA, AFC/FEI, RSSI and IRQ flags, which the chip updates by itself)
+static const byte SHADOWED[] = { 0xFE, 0xFB, 0xFF, 0x3E, 0x60, 0xFE, 0xFF, 0x3F };
+#define isShadowed(addr) ((addr) <= REG_SHADOW_LAST && (SHADOWED[(addr) >> 3] & (1 << ((addr) & 7))))
+//ListenAbort and RxRestart are one-shot triggers that always have to reach the chip and read back as 0
+#define shadowTrigger(addr) ((addr) == REG_OPMODE ? RF_OPMODE_LISTENABORT : ((addr) == REG_PACKETCONFIG2 ? RF_PACKET2_RXRESTART : 0))
 
 bool RFM69::initialize(byte freqBand, byte nodeID, byte networkID)
 {
@@ -35,9 +48,9 @@ bool RFM69::initialize(byte freqBand, byte nodeID, byte networkID)
     /* 0x05 */ { REG_FDEVMSB, RF_FDEVMSB_90000 }, //default:90khz, (FDEV + BitRate/2 <= 500Khz)
     /* 0x06 */ { REG_FDEVLSB, RF_FDEVLSB_90000 },
 
-    /* 0x07 */ { REG_FRFMSB, (freqBand==RF69_315MHZ ? RF_FRFMSB_315 : (freqBand==RF69_433MHZ ? RF_FRFMSB_433 : (freqBand==RF69_868MHZ ? RF_FRFMSB_868 : RF_FRFMSB_915))) },
-    /* 0x08 */ { REG_FRFMID, (freqBand==RF69_315MHZ ? RF_FRFMID_315 : (freqBand==RF69_433MHZ ? RF_FRFMID_433 : (freqBand==RF69_868MHZ ? RF_FRFMID_868 : RF_FRFMID_915))) },
-    /* 0x09 */ { REG_FRFLSB, (freqBand==RF69_315MHZ ? RF_FRFLSB_315 : (freqBand==RF69_433MHZ ? RF_FRFLSB_433 : (freqBand==RF69_868MHZ ? RF_FRFLSB_868 : RF_FRFLSB_915))) },
+    /* 0x07 */ { REG_FRFMSB, (byte)(freqBand==RF69_315MHZ ? RF_FRFMSB_315 : (freqBand==RF69_433MHZ ? RF_FRFMSB_433 : (freqBand==RF69_868MHZ ? RF_FRFMSB_868 : RF_FRFMSB_915))) },
+    /* 0x08 */ { REG_FRFMID, (byte)(freqBand==RF69_315MHZ ? RF_FRFMID_315 : (freqBand==RF69_433MHZ ? RF_FRFMID_433 : (freqBand==RF69_868MHZ ? RF_FRFMID_868 : RF_FRFMID_915))) },
+    /* 0x09 */ { REG_FRFLSB, (byte)(freqBand==RF69_315MHZ ? RF_FRFLSB_315 : (freqBand==RF69_433MHZ ? RF_FRFLSB_433 : (freqBand==RF69_868MHZ ? RF_FRFLSB_868 : RF_FRFLSB_915))) },
     
     // looks like PA1 and PA2 are not implemented on RFM69W, hence the max output power is 13dBm
     // +17dBm and +20dBm are possible on RFM69HW
@@ -58,27 +71,37 @@ bool RFM69::initialize(byte freqBand, byte nodeID, byte networkID)
     /* 0x2e */ { REG_SYNCCONFIG, RF_SYNC_ON | RF_SYNC_FIFOFILL_AUTO | RF_SYNC_SIZE_2 | RF_SYNC_TOL_0 },
     /* 0x2f */ { REG_SYNCVALUE1, 0x2D },      //attempt to make this compatible with sync1 byte of RFM12B lib
     /* 0x30 */ { REG_SYNCVALUE2, networkID }, //NETWORK ID
-    /* 0x37 */ { REG_PACKETCONFIG1, RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_OFF | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_ON | RF_PACKET1_ADRSFILTERING_NODEBROADCAST },
+    /* 0x37 */ { REG_PACKETCONFIG1, (byte)(RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_OFF | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_OFF | (_promiscuousMode ? RF_PACKET1_ADRSFILTERING_OFF : RF_PACKET1_ADRSFILTERING_NODEBROADCAST)) }, //bad CRCs still raise PayloadReady so they can be counted
     /* 0x38 */ { REG_PAYLOADLENGTH, 66 }, //in variable length mode: the max frame size, not used in TX
     /* 0x39 */ { REG_NODEADRS, nodeID }, //address filtering
-    /* 0x3a */ { REG_BROADCASTADRS, 0 }, //0 is the broadcast address
+    /* 0x3a */ { REG_BROADCASTADRS, RF69_BROADCAST_ADDR }, //the radio drops frames for other nodes before they reach the FIFO
     /* 0x3C */ { REG_FIFOTHRESH, RF_FIFOTHRESH_TXSTART_FIFONOTEMPTY | RF_FIFOTHRESH_VALUE }, //TX on FIFO not empty
     /* 0x3d */ { REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_2BITS | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF }, //RXRESTARTDELAY must match transmitter PA ramp-down time (bitrate dependent)
     /* 0x6F */ { REG_TESTDAGC, RF_DAGC_IMPROVED_LOWBETA0 }, // run DAGC continuously in RX mode, recommended default for AfcLowBetaOn=0
     {255, 0}
   };
 
+  if (_interruptNum >= RF69_MAX_IRQ)
+    return false;
+
   pinMode(_slaveSelectPin, OUTPUT);
   SPI.setDataMode(SPI_MODE0);
   SPI.setBitOrder(MSBFIRST);
   SPI.setClockDivider(SPI_CLOCK_DIV2); //max speed, except on Due which can run at system clock speed
   SPI.begin();
+  memset(_shadowValid, 0, sizeof(_shadowValid)); //the radio may have been reset since the mirror was filled
   
-  do writeReg(REG_SYNCVALUE1, 0xaa); while (readReg(REG_SYNCVALUE1) != 0xaa);
-	do writeReg(REG_SYNCVALUE1, 0x55); while (readReg(REG_SYNCVALUE1) != 0x55);
+  do writeReg(REG_SYNCVALUE1, 0xaa); while (readRegDirect(REG_SYNCVALUE1) != 0xaa);
+	do writeReg(REG_SYNCVALUE1, 0x55); while (readRegDirect(REG_SYNCVALUE1) != 0x55);
   
-  for (byte i = 0; CONFIG[i][0] != 255; i++)
-    writeReg(CONFIG[i][0], CONFIG[i][1]);
+  //each run of consecutive registers in the table goes out in a single burst
+  for (byte i = 0, n; CONFIG[i][0] != 255; i += n)
+  {
+    byte run[sizeof(CONFIG) / 2];
+    for (n = 0; CONFIG[i + n][0] == CONFIG[i][0] + n; n++)
+      run[n] = CONFIG[i + n][1];
+    writeRegBurst(CONFIG[i][0], run, n);
+  }
 
   // Encryption is persistent between resets and can trip you up during debugging.
   // Disable it during initialization so we always start from a known state.
@@ -87,28 +110,254 @@ bool RFM69::initialize(byte freqBand, byte nodeID, byte networkID)
   setHighPower(_isRFM69HW); //called regardless if it's a RFM69W or RFM69HW
   setMode(RF69_MODE_STANDBY);
 	while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // Wait for ModeReady
-  attachInterrupt(0, RFM69::isr0, RISING);
-  
-  selfPointer = this;
   _address = nodeID;
+  _frf = ((uint32_t)readReg(REG_FRFMSB) << 16) | ((word)readReg(REG_FRFMID) << 8) | readReg(REG_FRFLSB);
+  _modeSince = millis();
+  _rnd = ((unsigned long)nodeID << 24) ^ millis() ^ 0x2545F491; //distinct per node so retries don't back off in lockstep
+  uint32_t rxDuration = RF69_LISTEN_RX_US, idleDuration = RF69_LISTEN_IDLE_US;
+  _listenConfig[0] = RF_LISTEN1_CRITERIA_RSSI | RF_LISTEN1_END_10; //wake on RSSI, back to listening after each frame
+  listenModeSetDurations(rxDuration, idleDuration);
+  attachIsr(_interruptNum, RISING);
+#ifdef HAVE_INPUT_CAPTURE
+  captureBegin(_interruptNum);
+#endif
   return true;
 }
 
 void RFM69::setFrequency(uint32_t FRF)
 {
-  writeReg(REG_FRFMSB, FRF >> 16);
-  writeReg(REG_FRFMID, FRF >> 8);
-  writeReg(REG_FRFLSB, FRF);
+  _frf = FRF;
+  tune(FRF + _frfTrim);
+}
+
+uint32_t RFM69::getFrequency() {
+  return _frf;
+}
+
+// The synthesizer takes the new frequency when the FRF LSB is written, so only the bytes that
+// change go out, ending with the LSB, in one burst. Keeps the dead time of a hop short
+void RFM69::tune(uint32_t FRF)
+{
+  byte frf[3] = { (byte)(FRF >> 16), (byte)(FRF >> 8), (byte)FRF };
+  byte first = readReg(REG_FRFMSB) != frf[0] ? 0 : (readReg(REG_FRFMID) != frf[1] ? 1 : 2);
+  writeRegBurst(REG_FRFMSB + first, frf + first, 3 - first);
+  if (_mode == RF69_MODE_RX)
+    writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); //relock the receiver on the new channel
+}
+
+// AFC: the receiver measures each frame's preamble and centres itself on it before the payload
+// (AfcAutoOn, cleared for the next frame), within the AFC bandwidth setModem() gives twice
+// RF69_FREQ_TOLERANCE, so the receiver bandwidth proper only has to leave room for
+// RF69_AFC_TOLERANCE. The offset lands in FREQERROR/RFM69Frame::afc, and the one a node's ACKs
+// came in with is averaged per node: frames to it go out at that offset, right into its receiver
+// even if it runs a narrow bandwidth without AFC. ACKs go out on the channel, so both ends of a
+// link can do this without one learning the other's correction. Re-applies a setModem() profile
+void RFM69::setAfc(bool onOff)
+{
+  _afcOn = onOff;
+  writeReg(REG_AFCFEI, onOff ? RF_AFCFEI_AFCAUTOCLEAR_ON | RF_AFCFEI_AFCAUTO_ON : RF_AFCFEI_AFCAUTO_OFF);
+  if (_modemProfile != 0xFF)
+    setModem(_modemProfile);
+}
+
+// Crystal drift over temperature from the crystal's datasheet, as ppb off nominal at t degrees C
+// (readTemperature()): ppbPerC * (t - refTemp) + ppbPerC2 * (t - refTemp)^2. Every frequency is
+// pulled back by that much, the temperature is read again before a send every RF69_DRIFT_INTERVAL
+void RFM69::setDriftCompensation(int ppbPerC, int ppbPerC2, int8_t refTemp)
+{
+  _driftLinear = ppbPerC;
+  _driftSquare = ppbPerC2;
+  _driftRef = refTemp;
+  _driftUpdated = 0;
+  if (!ppbPerC && !ppbPerC2 && _frfTrim)
+  {
+    _frfTrim = 0;
+    tune(_frf);
+  }
+}
+
+// Must be in standby, the temperature sensor doesn't work in RX
+void RFM69::updateDrift()
+{
+  if ((!_driftLinear && !_driftSquare) || (_driftUpdated && millis() - _driftUpdated < RF69_DRIFT_INTERVAL))
+    return;
+  int t = (int8_t)readTemperature() - _driftRef;
+  long ppb = (long)_driftLinear * t + (long)_driftSquare * t * t;
+  if (ppb > 100000) ppb = 100000; //100ppm is far beyond any crystal, keeps the product below in range
+  if (ppb < -100000) ppb = -100000;
+  _frfTrim = -(long)(_frf >> 10) * ppb / 976563; //FRF * ppb / 10^9
+  _driftUpdated = millis() | 1;
+  tune(_frf + _frfTrim);
+}
+
+// An ACK from a node came in at the offset it transmits at, see setAfc()
+void RFM69::learnOffset(const RFM69Frame& frame)
+{
+  if (!_afcOn || !(frame.ctl & RF69_CTL_SENDACK))
+    return;
+  RFM69Peer* peer = getPeer(frame.senderID);
+  if (!peer)
+    return;
+  if (!peer->freqSamples)
+    peer->freqOffset = frame.afc;
+  else
+    peer->freqOffset += (frame.afc - peer->freqOffset) / 4;
+  if (peer->freqSamples < 255)
+    peer->freqSamples++;
+}
+
+// Frequency hopping: every node of the network steps through frfTable in the same pseudo-random
+// order (seeded by the network ID), dwellMs on each channel. Frames carry the sender's position
+// within its dwell so a receiver that heard one aligns its hop clock to the sender's.
+// Until then, or after RF69_HOP_LOCK_CYCLES quiet sequences, a receiver parks on the first channel
+// of the sequence, which a sender passes once per sequence. Hops happen when the driver is polled
+// (receiveDone(), send...), so the sketch has to keep calling receiveDone() as usual
+bool RFM69::setHopping(const uint32_t* frfTable, byte channels, word dwellMs)
+{
+  if (!frfTable || !channels)
+  {
+    _hopCount = 0;
+    return true;
+  }
+#if RF69_HOP_MAX_CHANNELS
+  if (channels > RF69_HOP_MAX_CHANNELS || !dwellMs)
+    return false;
+  unsigned long x = readReg(REG_SYNCVALUE2) * 0x9E3779B1UL + 1; //same permutation on every node of the network
+  for (byte i = 0; i < channels; i++)
+    _hopSeq[i] = i;
+  for (byte i = channels - 1; i > 0; i--) //Fisher-Yates
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    byte j = x % (i + 1);
+    byte tmp = _hopSeq[i];
+    _hopSeq[i] = _hopSeq[j];
+    _hopSeq[j] = tmp;
+  }
+  _hopTable = frfTable;
+  _hopDwell = dwellMs;
+  _hopEpoch = millis();
+  _hopLastSync = millis() - (unsigned long)channels * dwellMs * RF69_HOP_LOCK_CYCLES; //not locked yet
+  _hopPos = 0;
+  _hopCount = channels;
+  setFrequency(_hopTable[_hopSeq[0]]);
+  return true;
+#else
+  return false;
+#endif
+}
+
+byte RFM69::getHopChannel() {
+#if RF69_HOP_MAX_CHANNELS
+  return _hopCount ? _hopSeq[_hopPos] : 0;
+#else
+  return 0;
+#endif
+}
+
+// Retune if the hop clock has moved on, but not while a frame is coming in
+void RFM69::updateHop()
+{
+#if RF69_HOP_MAX_CHANNELS
+  if (!_hopCount)
+    return;
+  unsigned long cycle = (unsigned long)_hopCount * _hopDwell;
+  byte pos = 0;
+  noInterrupts(); //the ISR moves the epoch on resync
+  unsigned long now = millis();
+  if (now - _hopLastSync < cycle * RF69_HOP_LOCK_CYCLES)
+  {
+    unsigned long elapsed = now - _hopEpoch;
+    if (elapsed >= cycle) //keep the epoch close so the arithmetic never wraps
+    {
+      _hopEpoch += elapsed - elapsed % cycle;
+      elapsed %= cycle;
+    }
+    pos = elapsed / _hopDwell;
+  }
+  interrupts();
+  if (pos == _hopPos)
+    return;
+  if (_mode == RF69_MODE_RX && (_rxStreaming || (readRegDirect(REG_IRQFLAGS1) & RF_IRQFLAGS1_SYNCADDRESSMATCH)))
+    return; //next poll
+  _hopPos = pos;
+  setFrequency(_hopTable[_hopSeq[pos]]);
+#endif
+}
+
+// Called from the ISR with the phase byte of a frame of size payload bytes that just ended on
+// channel _hopPos: the sender's dwell began the frame's airtime plus phase/256 dwells before heard
+void RFM69::resyncHop(byte phase, byte size, unsigned long heard)
+{
+  unsigned long dwellStart = heard - (getAirtime(size) + 500) / 1000 - (unsigned long)phase * _hopDwell / 256;
+  _hopEpoch = dwellStart - (unsigned long)_hopPos * _hopDwell;
+  _hopLastSync = heard;
+}
+
+// Extension headers the library adds to any frame are consumed here and stripped, so the queue
+// holds the payload the sender passed in. Times in them count from the frame's end, not from now
+void RFM69::receiveHeaders(RFM69Frame* frame)
+{
+  byte size = frame->datalen;
+  unsigned long heard = millis() - (timestampNow() - frame->timestamp) / (TIMESTAMP_RATE / 1000);
+  while ((frame->ctl & RF69_CTL_EXT) && frame->datalen)
+  {
+    byte ext = frame->data[0];
+    byte len;
+    switch (ext & RF69_EXT_TYPE)
+    {
+      case RF69_EXT_HOP:
+        len = 2;
+        if (frame->datalen >= len && _hopCount)
+          resyncHop(frame->data[1], size, heard);
+        break;
+      case RF69_EXT_RSSI:
+        len = ext & RF69_EXT_REPORT ? 2 : 1;
+        if (len == 1)
+          frame->rssiRequested = true;
+        else if (frame->datalen >= len)
+        {
+          _ackRssi = frame->data[1];
+          _ackRssiFrom = frame->senderID;
+        }
+        break;
+      case RF69_EXT_RATE:
+        len = 2;
+        if (frame->datalen >= len && _rateBase != 0xFF && frame->targetID == _address
+            && frame->data[1] >= _rateBase && frame->data[1] <= _rateMax)
+          _rateSwitch = frame->data[1];
+        break;
+      case RF69_EXT_WAKE:
+        len = 3;
+        if (frame->datalen >= len)
+          _burstHeard = heard + (frame->data[1] | (frame->data[2] << 8));
+        break;
+      default:
+        return; //not ours to strip (sendBulk() frames) or unknown
+    }
+    if (len > frame->datalen)
+      len = frame->datalen;
+    frame->datalen -= len;
+    memmove(frame->data, frame->data + len, frame->datalen);
+    if (!(ext & RF69_EXT_MORE))
+      frame->ctl &= ~RF69_CTL_EXT;
+  }
 }
 
 void RFM69::setMode(byte newMode)
 {
 	if (newMode == _mode) return; //TODO: can remove this?
 
+  if (_mode == RF69_MODE_LISTEN) //ListenOn has to be cleared together with ListenAbort
+  {
+    writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0x80) | RF_OPMODE_LISTENABORT | RF_OPMODE_STANDBY);
+    writeReg(REG_RXTIMEOUT2, 0);
+  }
 	switch (newMode) {
 		case RF69_MODE_TX:
 			writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_TRANSMITTER);
-      if (_isRFM69HW) setHighPowerRegs(true);
+      if (_isRFM69HW) setHighPowerRegs(_paBoost);
 			break;
 		case RF69_MODE_RX:
 			writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_RECEIVER);
@@ -123,6 +372,9 @@ void RFM69::setMode(byte newMode)
 		case RF69_MODE_SLEEP:
 			writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_SLEEP);
 			break;
+    case RF69_MODE_LISTEN:
+      writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xA3) | RF_OPMODE_LISTEN_ON | RF_OPMODE_STANDBY);
+      break;
 		default: return;
 	}
 
@@ -130,7 +382,12 @@ void RFM69::setMode(byte newMode)
   // but waiting for mode ready is necessary when going from sleep because the FIFO may not be immediately available from previous mode
 	while (_mode == RF69_MODE_SLEEP && (readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // Wait for ModeReady
 
+  noInterrupts(); //the ISR changes modes too, neither may see half an update
+  unsigned long now = millis();
+  _stats.modeTime[_mode] += now - _modeSince;
+  _modeSince = now;
 	_mode = newMode;
+  interrupts();
 }
 
 void RFM69::sleep() {
@@ -151,12 +408,61 @@ void RFM69::setPowerLevel(byte powerLevel)
   writeReg(REG_PALEVEL, (readReg(REG_PALEVEL) & 0xE0) | (_powerLevel > 31 ? 31 : _powerLevel));
 }
 
+// -18..+13dBm on PA0 for RFM69W. RFM69HW: PA1 alone up to +13dBm, PA1+PA2 up to +17dBm,
+// and the high power settings on top for +18..+20dBm (section 3.3.7 in datasheet)
+void RFM69::setPowerDBm(int8_t dBm)
+{
+  byte pa = RF_PALEVEL_PA0_ON;
+  int level = dBm + 18;
+  _paBoost = false;
+  if (_isRFM69HW)
+  {
+    pa = RF_PALEVEL_PA1_ON;
+    if (dBm > 17)
+    {
+      pa |= RF_PALEVEL_PA2_ON;
+      level = dBm + 11;
+      _paBoost = true;
+    }
+    else if (dBm > 13)
+    {
+      pa |= RF_PALEVEL_PA2_ON;
+      level = dBm + 14;
+    }
+    if (level < 16) level = 16; //PA1 and PA2 don't go lower
+  }
+  writeReg(REG_PALEVEL, pa | (level < 0 ? 0 : (level > 31 ? 31 : level)));
+}
+
+// Automatic transmit power control: frames that request an ACK ask the destination for the RSSI
+// it heard them at, sendWithRetry() then moves the power used for that destination towards
+// targetRSSI. Up by the shortfall right away and RF69_ATPC_STEP_UP per missed ACK, down by 1dB
+// per ACK while the margin is over RF69_ATPC_HYSTERESIS. Broadcasts and unknown destinations get
+// full power. Receivers report RSSI whether or not they run ATPC themselves
+void RFM69::enableAutoPower(int8_t targetRSSI)
+{
+  _atpcTarget = targetRSSI;
+  if (!targetRSSI)
+  {
+    setHighPower(_isRFM69HW);
+    setPowerLevel(_powerLevel);
+  }
+}
+
+// step > 0 raises the power for peer by that many dB, < 0 lowers it
+void RFM69::updatePower(RFM69Peer* peer, int step)
+{
+  int backoff = peer->txBackoff - step;
+  int range = _isRFM69HW ? 20 - (-2) : 13 - (-18);
+  peer->txBackoff = backoff < 0 ? 0 : (backoff > range ? range : backoff);
+}
+
 bool RFM69::canSend()
 {
 #if DISABLE_RSSI_CHECK
-  if (_mode == RF69_MODE_RX && PAYLOADLEN == 0)
+  if (_mode == RF69_MODE_RX)
 #else
-  if (_mode == RF69_MODE_RX && PAYLOADLEN == 0 && readRSSI() < CSMA_LIMIT) //if signal stronger than -100dBm is detected assume channel activity
+  if (_mode == RF69_MODE_RX && readRSSI() < _csmaLimit) //if signal stronger than the limit is detected assume channel activity
 #endif
   {
     setMode(RF69_MODE_STANDBY);
@@ -166,240 +472,1837 @@ bool RFM69::canSend()
   {
     return true;
   }
+  else if (_mode == RF69_MODE_LISTEN)
+    armReceiver(); //leave listen mode, the next call can sense the channel
   return false;
 }
 
-void RFM69::send(byte toAddress, const void* buffer, byte bufferSize, bool requestACK)
+byte RFM69::send(byte toAddress, const void* buffer, byte bufferSize, bool requestACK)
+{
+  return sendSequenced(toAddress, buffer, bufferSize, requestACK, nextSeq(toAddress));
+}
+
+byte RFM69::sendSequenced(byte toAddress, const void* buffer, byte bufferSize, bool requestACK, byte seq)
 {
   writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  while (!canSend()) receiveDone();
-  sendFrame(toAddress, buffer, bufferSize, requestACK, false);
+  byte result = waitDutyCycle(bufferSize, _dutyMaxWait);
+  if (result == RF69_TX_OK)
+    result = accessChannel();
+  if (result == RF69_TX_OK)
+    sendFrame(toAddress, buffer, bufferSize, requestACK, false, seq);
+  return result;
 }
 
-// to increase the chance of getting a packet across, call this function instead of send
-// and it handles all the ACK requesting/retrying for you :)
-// The only twist is that you have to manually listen to ACK requests on the other side and send back the ACKs
-// The reason for the semi-automaton is that the lib is ingterrupt driven and
-// requires user action to read the received data and decide what to do with it
-// replies usually take only 5-8ms at 50kbps@915Mhz
-bool RFM69::sendWithRetry(byte toAddress, const void* buffer, byte bufferSize, byte retries, byte retryWaitTime) {
-  long sentTime;
-  for (byte i=0; i<=retries; i++)
+// Listen before talk: the channel has to stay below the RSSI limit for a random number of
+// slots out of the contention window, which doubles whenever the channel is busy so nodes
+// woken at the same moment spread out instead of colliding again. ACKs skip the contention
+// (contend=false) and only wait for a clear channel.
+// Leaves the radio in STANDBY ready to transmit, or in RX after maxAccessTime with RF69_TX_CHANNEL_BUSY
+byte RFM69::accessChannel(bool contend)
+{
+  while (_mode == RF69_MODE_TX); //startSend() frame still on air
+  unsigned long start = millis();
+#if !DISABLE_RSSI_CHECK
+  word window = RF69_CSMA_CW_MIN;
+  byte slots = contend ? random16() % window : 0;
+  if (_mode != RF69_MODE_RX)
+    armReceiver();
+  for (;;)
   {
-    send(toAddress, buffer, bufferSize, true);
-    sentTime = millis();
+    updateHop(); //sense the channel the frame will go out on
+    bool busy = false;
+    unsigned long slotStart = millis();
     do
+      busy = readRSSI() >= _csmaLimit;
+    while (!busy && slots && millis() - slotStart <= RF69_CSMA_SLOT);
+    if (busy)
     {
-      if (ACKReceived(toAddress))
+      _stats.channelBusy++;
+      if (contend)
       {
-        //Serial.print(" ~ms:");Serial.print(millis()-sentTime);
-        return true;
+        if (window < RF69_CSMA_CW_MAX)
+          window <<= 1;
+        slots = random16() % window;
       }
-    } while (millis()-sentTime<retryWaitTime);
-    //Serial.print(" RETRY#");Serial.println(i+1);
+    }
+    else if (!slots--)
+      break;
+    if (millis() - start >= _csmaMaxTime)
+    {
+      _stats.channelFailures++;
+      _stats.channelAccessTime += millis() - start;
+      return RF69_TX_CHANNEL_BUSY;
+    }
   }
-  return false;
+#endif
+  setMode(RF69_MODE_STANDBY);
+  _stats.channelAccessTime += millis() - start;
+  return RF69_TX_OK;
 }
 
-/// Should be polled immediately after sending a packet with ACK request
-bool RFM69::ACKReceived(byte fromNodeID) {
-  if (receiveDone())
-    return (SENDERID == fromNodeID || fromNodeID == RF69_BROADCAST_ADDR) && ACK_RECEIVED;
-  return false;
+// Listen mode: the chip alternates idle (~1.2uA) and short RX windows on its own RC timer.
+// A wake-up criterion met in an RX window keeps the receiver on until PayloadReady (or
+// RF69_LISTEN_RSSI_TIMEOUT), the ISR queues the frame as usual and the chip goes back to listening.
+// The average current is about the RX current times rxDuration / (rxDuration + idleDuration),
+// ~32uA with the defaults. Senders reach such a node with listenModeSendBurst()
+static byte listenResolution(uint32_t& duration, byte& coef)
+{
+  static const uint32_t resolution[] = { 64, 4100, 262000 };
+  for (byte i = 0; i < 3; i++)
+  {
+    uint32_t c = (duration + resolution[i] / 2) / resolution[i];
+    if (c <= 255)
+    {
+      coef = c ? c : 1;
+      duration = coef * resolution[i];
+      return i + 1;
+    }
+  }
+  return 0;
 }
 
-/// Should be called immediately after reception in case sender wants ACK
-void RFM69::sendACK(const void* buffer, byte bufferSize) {
-  byte sender = SENDERID;
-  while (!canSend()) receiveDone();
-  sendFrame(sender, buffer, bufferSize, false, true);
+bool RFM69::listenModeSetDurations(uint32_t& rxDuration, uint32_t& idleDuration)
+{
+  byte rxCoef, idleCoef;
+  byte rxResol = listenResolution(rxDuration, rxCoef);
+  byte idleResol = listenResolution(idleDuration, idleCoef);
+  if (!rxResol || !idleResol)
+    return false;
+  _listenConfig[0] = (idleResol << 6) | (rxResol << 4) | (_listenConfig[0] & 0x0F);
+  _listenConfig[1] = idleCoef;
+  _listenConfig[2] = rxCoef;
+  return true;
 }
 
-void RFM69::sendFrame(byte toAddress, const void* buffer, byte bufferSize, bool requestACK, bool sendACK)
+void RFM69::listenModeGetDurations(uint32_t& rxDuration, uint32_t& idleDuration)
 {
-  setMode(RF69_MODE_STANDBY); //turn off receiver to prevent reception while filling fifo
-	while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // Wait for ModeReady
-  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_00); // DIO0 is "Packet Sent"
-  if (bufferSize > MAX_DATA_LEN) bufferSize = MAX_DATA_LEN;
+  static const uint32_t resolution[] = { 0, 64, 4100, 262000 };
+  idleDuration = resolution[_listenConfig[0] >> 6] * _listenConfig[1];
+  rxDuration = resolution[(_listenConfig[0] >> 4) & 0x03] * _listenConfig[2];
+}
 
-	//write to FIFO
-	select();
-	SPI.transfer(REG_FIFO | 0x80);
-	SPI.transfer(bufferSize + 3);
-	SPI.transfer(toAddress);
-  SPI.transfer(_address);
-  
-  //control byte
-  if (sendACK)
-    SPI.transfer(0x80);
-  else if (requestACK)
-    SPI.transfer(0x40);
-  else SPI.transfer(0x00);
-  
-	for (byte i = 0; i < bufferSize; i++)
-    SPI.transfer(((byte*)buffer)[i]);
-	unselect();
+// RSSI alone wakes up fastest and allows the shortest RX window, RSSI and sync address
+// needs the window to span preamble and sync word but ignores other networks and noise
+void RFM69::listenModeSetCriteria(byte criteria) {
+  _listenConfig[0] = (_listenConfig[0] & ~RF_LISTEN1_CRITERIA_RSSIANDSYNC) | (criteria & RF_LISTEN1_CRITERIA_RSSIANDSYNC);
+}
 
-	/* no need to wait for transmit mode to be ready since its handled by the radio */
-	setMode(RF69_MODE_TX);
-	while (digitalRead(_interruptPin) == 0); //wait for DIO0 to turn HIGH signalling transmission finish
-  //while (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT == 0x00); // Wait for ModeReady
+void RFM69::listenModeStart()
+{
+  while (_mode == RF69_MODE_TX); //startSend() frame still on air
+  if (_mode == RF69_MODE_LISTEN)
+    return;
+  if (_rxStreaming)
+    dropFrame(true);
   setMode(RF69_MODE_STANDBY);
+  writeRegBurst(REG_LISTEN1, _listenConfig, sizeof(_listenConfig));
+  writeReg(REG_RXTIMEOUT2, RF69_LISTEN_RSSI_TIMEOUT); //back to idle if an RSSI wake-up brings no frame
+  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01); //PayloadReady
+  clearFIFO();
+  setMode(RF69_MODE_LISTEN);
 }
 
-void RFM69::interruptHandler() {
-  //pinMode(4, OUTPUT);
-  //digitalWrite(4, 1);
-  if (_mode == RF69_MODE_RX && (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY))
-  {
+void RFM69::listenModeEnd() {
+  if (_mode == RF69_MODE_LISTEN)
     setMode(RF69_MODE_STANDBY);
-    select();
-    SPI.transfer(REG_FIFO & 0x7f);
-    PAYLOADLEN = SPI.transfer(0);
-    PAYLOADLEN = PAYLOADLEN > 66 ? 66 : PAYLOADLEN; //precaution
-    TARGETID = SPI.transfer(0);
-    if(!(_promiscuousMode || TARGETID==_address || TARGETID==RF69_BROADCAST_ADDR)) //match this node's address, or broadcast address or anything in promiscuous mode
-    {
-      PAYLOADLEN = 0;
-      unselect();
-      //digitalWrite(4, 0);
-      return;
-    }
-    if (PAYLOADLEN < 3) //payload too short?
-    {
-      PAYLOADLEN = 0;
-      unselect();
-      return;
-    }
-    DATALEN = PAYLOADLEN - 3;
-    SENDERID = SPI.transfer(0);
-    byte CTLbyte = SPI.transfer(0);
-    
-    ACK_RECEIVED = CTLbyte & 0x80; //extract ACK-requested flag
-    ACK_REQUESTED = CTLbyte & 0x40; //extract ACK-received flag
-    
-    for (byte i= 0; i < DATALEN; i++)
-    {
-      DATA[i] = SPI.transfer(0);
-    }
-    unselect();
-    setMode(RF69_MODE_RX);
-  }
-#if !DISABLE_RSSI_CHECK
-  RSSI = readRSSI();
-#endif
-  //digitalWrite(4, 0);
 }
 
-void RFM69::isr0() { selfPointer->interruptHandler(); }
+// The same frame back to back for a whole listen period plus one frame, so a listening node's
+// RX window catches a copy wherever in its cycle it is. The copies share a sequence number
+// (the duplicate filter keeps one) and tell how long the burst still goes on, see getBurstRemaining().
+// With setDutyCycle() the burst only starts once the credit covers all of it
+byte RFM69::listenModeSendBurst(byte toAddress, const void* buffer, byte bufferSize)
+{
+  uint32_t rxDuration, idleDuration;
+  listenModeGetDurations(rxDuration, idleDuration);
+  writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
+  unsigned long burst = rxDuration + idleDuration + getAirtime(bufferSize + RF69_EXT_MAX); //us, copies go out back to back all along
+  byte result = waitAirtime(burst, _dutyMaxWait); //the whole burst or nothing, its copies are charged one by one
+  if (result == RF69_TX_OK)
+    result = accessChannel();
+  if (result != RF69_TX_OK)
+    return result;
+  byte seq = nextSeq(toAddress);
+  _burstEnd = millis() + burst / 1000 + 1;
+  if (!_burstEnd) _burstEnd = 1; //0 means no burst
+  do
+    sendFrame(toAddress, buffer, bufferSize, false, false, seq);
+  while ((long)(_burstEnd - millis()) > 0);
+  _burstEnd = 0;
+  return RF69_TX_OK;
+}
 
-void RFM69::receiveStart() {
-  if (_mode != RF69_MODE_RX)
-  {
-    receiveBegin();
-  }
+word RFM69::getBurstRemaining() {
+  long remaining = _burstHeard - millis();
+  return remaining > 0 ? remaining : 0;
 }
 
-void RFM69::receiveBegin() {
-  DATALEN = 0;
-  SENDERID = 0;
-  TARGETID = 0;
-  PAYLOADLEN = 0;
-  ACK_REQUESTED = 0;
-  ACK_RECEIVED = 0;
-  RSSI = 0;
-  if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)
-    writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01); //set DIO0 to "PAYLOADREADY" in receive mode
-  setMode(RF69_MODE_RX);
+// smallest FSK channel filter bandwidth of at least hz as RXBW/AFCBW mantissa and exponent bits,
+// RxBw = FXOSC / (mant * 2^(exp + 2)), 0xFF if over the 500kHz maximum
+static byte bandwidthBits(unsigned long hz)
+{
+  static const byte mant[] = { 24, 20, 16 };
+  for (char exp = 7; exp >= 0; exp--)
+    for (byte i = 0; i < 3; i++)
+      if (RF69_FXOSC_MHZ * 1000000UL / ((unsigned long)mant[i] << (exp + 2)) >= hz)
+        return ((2 - i) << 3) | exp;
+  return 0xFF;
 }
 
-bool RFM69::receiveDone() {
-// ATOMIC_BLOCK(ATOMIC_FORCEON)
-// {
-  noInterrupts(); //re-enabled in unselect() via setMode() or via receiveBegin()
-  if (_mode == RF69_MODE_RX && PAYLOADLEN>0)
-  {
-    setMode(RF69_MODE_STANDBY); //enables interrupts
-    return true;
-  }
-  else if (_mode == RF69_MODE_RX)  //already in RX no payload yet
-  {
-    interrupts(); //explicitly re-enable interrupts
+static unsigned long bandwidthHz(byte bits)
+{
+  static const byte mant[] = { 16, 20, 24 };
+  return RF69_FXOSC_MHZ * 1000000UL / ((unsigned long)mant[(bits >> 3) & 0x03] << ((bits & 0x07) + 2));
+}
+
+//bitrate, FDEV, RxBw (0 = from bitrate and FDEV) of the RF69_MODEM_* profiles
+static const unsigned long MODEM_PROFILES[RF69_MODEM_PROFILES][3] =
+{
+  { 2694, 90000, 125000 }, //the original custom 0x2E66 bitrate
+  { 4800, 5000, 0 },
+  { 9600, 10000, 0 },
+  { 19200, 20000, 0 },
+  { 38400, 40000, 0 },
+  { 55555, 50000, 0 },
+  { 100000, 100000, 0 },
+  { 200000, 100000, 0 },
+  { 300000, 100000, 0 },
+};
+
+bool RFM69::setModem(byte profile)
+{
+  if (profile >= RF69_MODEM_PROFILES || !setModem(MODEM_PROFILES[profile][0], MODEM_PROFILES[profile][1], MODEM_PROFILES[profile][2]))
     return false;
-  }
-  receiveBegin();
-  return false;
-//}
+  _modemProfile = profile;
+  return true;
 }
 
-// To enable encryption: radio.encrypt("ABCDEFGHIJKLMNOP");
-// To disable encryption: radio.encrypt(null) or radio.encrypt(0)
-// KEY HAS TO BE 16 bytes !!!
-void RFM69::encrypt(const char* key) {
+// Programs bitrate, frequency deviation, RX and AFC bandwidths and the RX restart delay together,
+// or nothing if the combination is one the SX1231 can't receive:
+// FDEV + BR/2 <= 500kHz, BR < 2 * RxBw and a modulation index 2 * FDEV / BR of at least 0.5.
+// Without rxBw the receiver gets FDEV + BR/2 plus RF69_FREQ_TOLERANCE (RF69_AFC_TOLERANCE with
+// setAfc()), the AFC twice RF69_FREQ_TOLERANCE
+bool RFM69::setModem(unsigned long bitrate, unsigned long fdev, unsigned long rxBw)
+{
+  unsigned long fxosc = RF69_FXOSC_MHZ * 1000000UL;
+  if (bitrate < fxosc / 0xFFFF || bitrate > 300000 || fdev + bitrate / 2 > 500000
+      || fdev * 4 < bitrate)
+    return false;
+  byte rxBits = bandwidthBits(rxBw ? rxBw : fdev + bitrate / 2 + (_afcOn ? RF69_AFC_TOLERANCE : RF69_FREQ_TOLERANCE));
+  byte afcBits = bandwidthBits(fdev + bitrate / 2 + 2 * RF69_FREQ_TOLERANCE);
+  if (rxBits == 0xFF)
+    return false;
+  if (afcBits == 0xFF)
+    afcBits = bandwidthBits(500000);
+  if (bitrate >= 2 * bandwidthHz(rxBits))
+    return false;
+
+  word br = (fxosc + bitrate / 2) / bitrate;
+  word fd = (fdev * 1024 + 31250) / 62500; //FSTEP = FXOSC / 2^19 = 62500 / 1024 Hz
+  byte delay = 1; //restart no sooner than 2^delay bits after PayloadReady, and after the sender's PA is down
+  while (delay < 11 && (1000000UL << delay) / bitrate < RF69_PA_RAMP_US)
+    delay++;
+
   setMode(RF69_MODE_STANDBY);
-  if (key!=0)
+  byte modem[4] = { (byte)(br >> 8), (byte)br, (byte)(fd >> 8), (byte)fd };
+  writeRegBurst(REG_BITRATEMSB, modem, sizeof(modem));
+  byte bw[2] = { (byte)(RF_RXBW_DCCFREQ_010 | rxBits), (byte)(RF_AFCBW_DCCFREQAFC_100 | afcBits) };
+  writeRegBurst(REG_RXBW, bw, sizeof(bw));
+  writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0x0F) | (delay << 4));
+  _modemProfile = 0xFF;
+  return true;
+}
+
+// Rate adaptation: every node idles on the profile set with setModem() before this call (the base),
+// and sendWithRetry() tracks per destination how often frames at each profile from the base to
+// maxProfile get through, like Minstrel: it goes for the profile with the best delivery ratio times
+// frames per second, and spends 1 in RF69_RATE_SAMPLE frames on another profile that could do better.
+// The rate is agreed in band: a frame carries an RF69_EXT_RATE header on the rate its destination
+// listens on, the destination switches once the frame is in and ACKs on the new rate, and both ends
+// fall back to the base RF69_RATE_HOLD ms after the last frame between them. A destination that
+// doesn't answer on a new rate may still be held there: sendWithRetry() returns false right away
+// instead of waiting out the hold, and a later call (RF69_RATE_HOLD ms on) goes out on the base.
+// While a node is off the base it hears nobody else: a gateway that switched for one node misses
+// the others' frames for up to RF69_RATE_HOLD ms after that node's last frame, they get through
+// on their retries, so give them retries (and backoff) that span more than RF69_RATE_HOLD.
+// All nodes need it on with the same base, ACKs and broadcasts use whatever rate we're on or the base
+bool RFM69::setRateAdaptation(bool onOff, byte maxProfile)
+{
+  if (!onOff)
   {
-    select();
-    SPI.transfer(REG_AESKEY1 | 0x80);
-    for (byte i = 0; i<16; i++)
-      SPI.transfer(key[i]);
-    unselect();
+    if (_rateBase != 0xFF)
+      setModem(_rateBase);
+    _rateBase = 0xFF;
+    return true;
   }
-  writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFE) | (key ? 1 : 0));
+  if (!RF69_PEER_SLOTS || _modemProfile == 0xFF || maxProfile >= RF69_MODEM_PROFILES || maxProfile < _modemProfile)
+    return false; //delivery ratios are learnt per destination
+  _rateBase = _modemProfile;
+  _rateMax = maxProfile;
+  _rateSwitch = 0xFF;
+  return true;
 }
 
-int RFM69::readRSSI(bool forceTrigger) {
-  int rssi = 0;
-  if (forceTrigger)
+// switch to the rate a received frame asked for, or back to the base once the hold is over
+void RFM69::updateRate()
+{
+  if (_rateBase == 0xFF)
+    return;
+  byte to = _rateSwitch;
+  if (to != 0xFF)
   {
-    //RSSI trigger not needed if DAGC is in continuous mode
-    writeReg(REG_RSSICONFIG, RF_RSSI_START);
-    while ((readReg(REG_RSSICONFIG) & RF_RSSI_DONE) == 0x00); // Wait for RSSI_Ready
+    _rateSwitch = 0xFF;
+    switchRate(to);
+    return;
   }
-  rssi = -readReg(REG_RSSIVALUE);
-  rssi >>= 1;
-  return rssi;
+  noInterrupts(); //the ISR renews the hold
+  bool over = (long)(millis() - _rateHoldUntil) >= 0;
+  interrupts();
+  if (!over || _modemProfile == _rateBase)
+    return;
+  if (_mode == RF69_MODE_TX || (_mode == RF69_MODE_RX && (_rxStreaming || (readRegDirect(REG_IRQFLAGS1) & RF_IRQFLAGS1_SYNCADDRESSMATCH))))
+    return; //next poll
+  switchRate(_rateBase);
 }
 
-byte RFM69::readReg(byte addr)
+void RFM69::switchRate(byte profile)
 {
-  select();
-  SPI.transfer(addr & 0x7F);
-  byte regval = SPI.transfer(0);
-  unselect();
-  return regval;
+  if (profile != _rateBase)
+    _rateHoldUntil = millis() + RF69_RATE_HOLD;
+  if (profile == _modemProfile)
+    return;
+  bool rx = receiving();
+  setModem(profile);
+  if (rx)
+    armReceiver();
 }
 
-void RFM69::writeReg(byte addr, byte value)
+// delivery ratio times exchanges per second of a payloadSize frame and its ACK at profile
+unsigned long RFM69::rateScore(byte profile, byte prob, byte payloadSize)
 {
-  select();
-  SPI.transfer(addr | 0x80);
-  SPI.transfer(value);
-  unselect();
+  unsigned long us = (payloadSize + 24UL) * 8000000UL / MODEM_PROFILES[profile][0] + RF69_RATE_TURNAROUND; //preamble, sync, header, CRC and an ACK
+  return prob * (1000000000UL / us);
 }
 
-/// Select the transceiver
-void RFM69::select() {
-  noInterrupts();
-  digitalWrite(_slaveSelectPin, LOW);
+byte RFM69::pickRate(RFM69Peer* peer, byte payloadSize)
+{
+  byte best = _rateBase;
+  unsigned long bestScore = 0;
+  for (byte p = _rateBase; p <= _rateMax; p++)
+  {
+    unsigned long score = rateScore(p, peer->rateProb[p], payloadSize);
+    if (score > bestScore)
+    {
+      best = p;
+      bestScore = score;
+    }
+  }
+  if (++_rateSamples >= RF69_RATE_SAMPLE)
+  {
+    _rateSamples = 0;
+    byte p = _rateBase + random16() % (_rateMax - _rateBase + 1);
+    if (p != best && rateScore(p, 255, payloadSize) > bestScore) //only rates that could beat the best one
+      return p;
+  }
+  return best;
 }
 
-/// UNselect the transceiver chip
-void RFM69::unselect() {
-  digitalWrite(_slaveSelectPin, HIGH);
-  interrupts();
+unsigned long RFM69::getBitrate()
+{
+  word br = (readReg(REG_BITRATEMSB) << 8) | readReg(REG_BITRATELSB);
+  return (RF69_FXOSC_MHZ * 1000000UL + br / 2) / br;
 }
 
-// ON  = disable filtering to capture all frames on network
-// OFF = enable node+broadcast filtering to capture only frames sent to this/broadcast address
+// Time on air from the current bitrate, preamble, sync, packet and AES settings:
+// preamble + sync + length byte + target/sender/ctl + payload + CRC, with AES the bytes after
+// the length (and the target address when address filtering is on) go out in 16 byte blocks,
+// with Manchester coding every bit after the sync word takes two
+unsigned long RFM69::getAirtime(byte payloadSize)
+{
+  word data = payloadSize + (_secure ? RF69_SECURITY_OVERHEAD : 0);
+  return frameAirtime(_fec ? RF69_FEC_CODED_LEN(data) : data);
+}
+
+// getAirtime() of a frame with dataLen bytes after the header as they go out, sealed and coded
+unsigned long RFM69::frameAirtime(word dataLen)
+{
+  byte packetConfig = readReg(REG_PACKETCONFIG1);
+  word bytes = (readReg(REG_PREAMBLEMSB) << 8) | readReg(REG_PREAMBLELSB);
+  word coded = 1 + 3 + dataLen; //length byte and header are always sent
+  if (readReg(REG_PACKETCONFIG2) & RF_PACKET2_AES_ON)
+  {
+    byte clear = 1 + ((packetConfig & 0x06) ? 1 : 0);
+    coded = clear + ((coded - clear + 15) & ~15);
+  }
+  if (packetConfig & RF_PACKET1_CRC_ON)
+    coded += 2;
+  if ((packetConfig & 0x60) == RF_PACKET1_DCFREE_MANCHESTER)
+    coded <<= 1;
+  if (readReg(REG_SYNCCONFIG) & RF_SYNC_ON)
+    bytes += ((readReg(REG_SYNCCONFIG) >> 3) & 0x07) + 1;
+  word bitrate = (readReg(REG_BITRATEMSB) << 8) | readReg(REG_BITRATELSB); //FXOSC / bits per second
+  return ((unsigned long)(bytes + coded) * 8 * bitrate + RF69_FXOSC_MHZ - 1) / RF69_FXOSC_MHZ;
+}
+
+// Both edges come at the end of the frame, the sync word of a received frame was detected
+// getAirtime(DATALEN) minus the preamble and sync time before TIMESTAMP. Between two nodes
+// with the same settings that offset is constant and drops out of the clock difference
+unsigned long RFM69::getSendTimestamp() {
+  noInterrupts();
+  unsigned long stamp = _txTimestamp;
+  interrupts();
+  return stamp;
+}
+
+unsigned long RFM69::getTimestampNow() {
+  return timestampNow();
+}
+
+unsigned long RFM69::getTimestampRate() {
+  return TIMESTAMP_RATE;
+}
+
+// Token bucket: airtime credit accrues at permille of real time, up to permille of periodMs,
+// so bursts are fine as long as the long term average stays within the duty cycle.
+// Frames that don't fit the credit wait up to maxWaitMs, then send() returns RF69_TX_DUTY_CYCLE.
+// ACKs are always sent and charged, they can push the credit below zero.
+// The bucket holds at most ~35 minutes of airtime (2^31 us), reached from 597 permille of an hour
+void RFM69::setDutyCycle(word permille, unsigned long periodMs, word maxWaitMs)
+{
+  _dutyPermille = permille;
+  _dutyMaxWait = maxWaitMs;
+  _dutyBucket = permille && periodMs > 0x7FFFFFFFUL / permille ? 0x7FFFFFFF : periodMs * permille;
+  _dutyTokens = _dutyBucket; //start with a full bucket
+  _dutyUpdated = millis();
+}
+
+long RFM69::getDutyCycleBudget() {
+  if (!_dutyPermille)
+    return 0x7FFFFFFF;
+  refillDutyCycle();
+  return _dutyTokens;
+}
+
+void RFM69::refillDutyCycle()
+{
+  unsigned long now = millis();
+  unsigned long elapsed = now - _dutyUpdated;
+  _dutyUpdated = now;
+  if (elapsed >= (unsigned long)_dutyBucket / _dutyPermille) //also keeps the multiplication below from overflowing
+    _dutyTokens = _dutyBucket;
+  else
+  {
+    unsigned long earned = elapsed * _dutyPermille; //1 ms at 1 permille earns 1 us
+    if (earned >= (unsigned long)_dutyBucket - _dutyTokens) //room left, in unsigned so a negative credit can't overflow it
+      _dutyTokens = _dutyBucket;
+    else
+      _dutyTokens += earned;
+  }
+}
+
+byte RFM69::waitDutyCycle(byte size, word maxWait)
+{
+  return _dutyPermille ? waitAirtime(getAirtime(size), maxWait) : RF69_TX_OK;
+}
+
+// Wait up to maxWait ms for airtime us of credit
+byte RFM69::waitAirtime(unsigned long airtime, word maxWait)
+{
+  if (!_dutyPermille)
+    return RF69_TX_OK;
+  unsigned long start = millis();
+  for (;;)
+  {
+    refillDutyCycle();
+    if (_dutyTokens >= (long)airtime)
+      return RF69_TX_OK;
+    if (millis() - start >= maxWait)
+    {
+      _stats.dutyCycleRejects++;
+      return RF69_TX_DUTY_CYCLE;
+    }
+  }
+}
+
+void RFM69::setCsma(int rssiLimit, word maxAccessTime) {
+  _csmaLimit = rssiLimit;
+  _csmaMaxTime = maxAccessTime;
+}
+
+unsigned long RFM69::getChannelBusy() {
+  return _stats.channelBusy;
+}
+
+unsigned long RFM69::getChannelFailures() {
+  return _stats.channelFailures;
+}
+
+unsigned long RFM69::getChannelAccessTime() {
+  return _stats.channelAccessTime;
+}
+
+#if RF69_DUPLICATE_FILTER
+// True if seq is the last sequence number heard from nodeID, within RF69_DUPLICATE_TIMEOUT
+// Numbering restarts at 1 when a node resets, an old entry must not drop its new frames
+bool RFM69::isDuplicate(byte nodeID, byte seq)
+{
+  for (byte i = 0; i < RF69_DUPLICATE_SLOTS; i++)
+    if (_rxSeq[i].seq && _rxSeq[i].nodeID == nodeID)
+      return _rxSeq[i].seq == seq && millis() - _rxSeq[i].heard < RF69_DUPLICATE_TIMEOUT;
+  return false;
+}
+
+void RFM69::rememberSeq(byte nodeID, byte seq)
+{
+  unsigned long now = millis();
+  RFM69RxSeq* entry = &_rxSeq[0];
+  for (byte i = 0; i < RF69_DUPLICATE_SLOTS; i++)
+  {
+    if (_rxSeq[i].seq && _rxSeq[i].nodeID == nodeID)
+    {
+      entry = &_rxSeq[i];
+      break;
+    }
+    if (!_rxSeq[i].seq || (entry->seq && now - _rxSeq[i].heard > now - entry->heard))
+      entry = &_rxSeq[i];
+  }
+  entry->nodeID = nodeID;
+  entry->seq = seq;
+  entry->heard = now;
+}
+#endif
+
+// New frames to a node get the next sequence number, retransmissions reuse theirs
+// A destination pushed out of _txSeq numbers from 1 again, like a node after a reset
+byte RFM69::nextSeq(byte toAddress)
+{
+  if (toAddress == RF69_BROADCAST_ADDR)
+    return 0;
+  byte i = 0;
+  while (i < RF69_SEQ_SLOTS - 1 && _txSeq[i].seq && _txSeq[i].nodeID != toAddress)
+    i++;
+  byte seq = _txSeq[i].seq && _txSeq[i].nodeID == toAddress ? _txSeq[i].seq % RF69_CTL_SEQ + 1 : 1;
+  memmove(&_txSeq[1], &_txSeq[0], i * sizeof(RFM69TxSeq));
+  _txSeq[0].nodeID = toAddress;
+  _txSeq[0].seq = seq;
+  return seq;
+}
+
+// Non-blocking send: loads the FIFO, starts the transmitter and returns right away
+// The PacketSent interrupt ends the transmission, poll sendDone() or use setSendDoneCallback()
+// Returns false without sending if the previous frame is still on air or the channel is busy
+bool RFM69::startSend(byte toAddress, const void* buffer, byte bufferSize, bool requestACK)
+{
+  if (_mode == RF69_MODE_TX)
+    return false;
+  writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
+  if (waitDutyCycle(bufferSize, 0) != RF69_TX_OK)
+    return false;
+  if (!canSend())
+  {
+    receiveStart();
+    return false;
+  }
+  startFrame(toAddress, buffer, bufferSize, requestACK, false, nextSeq(toAddress));
+  return true;
+}
+
+bool RFM69::sendDone() {
+  return _mode != RF69_MODE_TX;
+}
+
+void RFM69::setSendDoneCallback(void (*callback)(void)) {
+  _sendDoneCallback = callback;
+}
+
+// The ISR drains each frame into a queue slot, receiveDone() then passes that slot to the callback
+// instead of copying the payload to DATA, so the payload is read straight from where the FIFO
+// left it. SENDERID, TARGETID, ACK_REQUESTED, RSSI and DATALEN are set as usual and sendACK() can
+// be called from the callback. The frame is only valid until the callback returns, and the
+// callback must not call receiveDone()/popFrame() itself. null goes back to DATA
+void RFM69::setReceiveCallback(void (*callback)(const RFM69Frame& frame)) {
+  _receiveCallback = callback;
+}
+
+// Lets receiveDone() put payloads straight into the sketch's own buffer (ex: the struct a node
+// sends) rather than DATA. Longer payloads are cut to bufferSize, DATALEN keeps the full length
+void RFM69::setReceiveBuffer(void* buffer, byte bufferSize) {
+  _rxBuffer = (byte*)buffer;
+  _rxBufferSize = bufferSize;
+}
+
+// to increase the chance of getting a packet across, call this function instead of send
+// and it handles all the ACK requesting/retrying for you :)
+// The only twist is that you have to manually listen to ACK requests on the other side and send back the ACKs
+// The reason for the semi-automaton is that the lib is ingterrupt driven and
+// requires user action to read the received data and decide what to do with it
+// replies usually take only 5-8ms at 50kbps@915Mhz
+// With retryWaitTime=0 the ACK timeout follows the measured round trip time to toAddress,
+// doubles with every retry and retries are spread by a random exponential backoff
+bool RFM69::sendWithRetry(byte toAddress, const void* buffer, byte bufferSize, byte retries, byte retryWaitTime) {
+  return sendReliable(toAddress, buffer, bufferSize, retries, retryWaitTime, 0);
+}
+
+// sendWithRetry() for the library's own frames too, ext = RF69_CTL_EXT when buffer starts with an extension header
+bool RFM69::sendReliable(byte toAddress, const void* buffer, byte bufferSize, byte retries, byte retryWaitTime, byte ext) {
+  unsigned long sentTime;
+  unsigned long firstSent = millis();
+#if RF69_PEER_SLOTS
+  RFM69Peer* peer = getPeer(toAddress, true);
+#else
+  RFM69Peer exchange = RFM69Peer(); //nothing is kept past this call
+  RFM69Peer* peer = &exchange;
+#endif
+  byte seq = nextSeq(toAddress) | ext;
+  byte want = _rateBase == 0xFF ? 0xFF : pickRate(peer, bufferSize);
+  byte rateFails = 0;
+  for (byte i=0; i<=retries; i++)
+  {
+    byte rate = 0xFF;
+    if (want != 0xFF)
+    {
+      if (rateFails >= 2 || (i == retries && i)) //no answer off the base rate
+      {
+        if ((long)(peer->rateUntil - millis()) > 0)
+          break; //it may be held off the base still, the caller tries again later rather than wait here
+        want = _rateBase;
+      }
+      if ((long)(peer->rateUntil - millis()) <= 0)
+        peer->rate = _rateBase;
+      rate = peer->rate;
+      _rateTx = want != rate ? want : 0xFF;
+    }
+    word waitTime = retryWaitTime;
+    if (!retryWaitTime)
+    {
+      waitTime = getAckTimeout(toAddress) << (i < 8 ? i : 8);
+      if (waitTime > RF69_ACK_TIMEOUT_MAX || waitTime < getAckTimeout(toAddress)) waitTime = RF69_ACK_TIMEOUT_MAX;
+      waitTime += random16() % ((word)RF69_BACKOFF_SLOT << (i < 8 ? i : 8)); //a late ACK is still taken during the backoff
+    }
+    if (i)
+    {
+      peer->retries++;
+      _stats.txRetries++;
+      if (_atpcTarget)
+        updatePower(peer, RF69_ATPC_STEP_UP);
+    }
+    _ackRssi = 0;
+    byte result = sendSequenced(toAddress, buffer, bufferSize, true, seq);
+    byte switchTo = _rateTx;
+    _rateTx = 0xFF;
+    if (result == RF69_TX_DUTY_CYCLE)
+      break; //retrying won't find more airtime
+    if (result != RF69_TX_OK)
+      continue; //no clear channel, that attempt is lost
+    if (switchTo != 0xFF)
+    {
+      switchRate(switchTo); //the ACK comes on the new rate
+      peer->rate = switchTo; //if the ACK gets lost the destination switched anyway
+      peer->rateUntil = millis() + RF69_RATE_HOLD;
+    }
+    sentTime = millis();
+    do
+    {
+      if (ACKReceived(toAddress))
+      {
+        if (i == 0) //Karn: an ACK after a retransmission can't tell which attempt it answers
+          updateRtt(peer, millis() - sentTime);
+        peer->delivered++;
+        peer->deliveryTime += millis() - firstSent;
+        if (rate != 0xFF)
+        {
+          peer->rateProb[rate] += (255 - peer->rateProb[rate] + 3) / 4;
+          if (switchTo != 0xFF) //the ACK made it on the new rate
+            peer->rateProb[switchTo] += (255 - peer->rateProb[switchTo] + 3) / 4;
+          peer->rateUntil = millis() + RF69_RATE_HOLD * 3 / 4; //the destination renewed its hold when the frame came in
+        }
+        if (_atpcTarget && _ackRssi && _ackRssiFrom == toAddress)
+        {
+          int margin = _ackRssi - _atpcTarget;
+          peer->ackRssi = _ackRssi;
+          if (margin < 0)
+            updatePower(peer, -margin);
+          else if (margin > RF69_ATPC_HYSTERESIS)
+            updatePower(peer, -1);
+        }
+        return true;
+      }
+    } while (millis()-sentTime<waitTime);
+    //Serial.print(" RETRY#");Serial.println(i+1);
+    if (rate != 0xFF)
+    {
+      peer->rateProb[rate] -= peer->rateProb[rate] / 4;
+      if (rate != _rateBase || switchTo != 0xFF)
+        rateFails++;
+    }
+  }
+  peer->failed++;
+  _stats.txFailures++;
+  peer->txBackoff = 0; //lost the link, start over from full power
+  return false;
+}
+
+// Jacobson/Karels estimator as used by TCP, srtt and rttvar are kept scaled by 8 and 4
+void RFM69::updateRtt(RFM69Peer* peer, word rtt)
+{
+  if (rtt == 0) rtt = 1; //millis() granularity, and srtt 0 means "no sample yet"
+  if (!peer->srtt)
+  {
+    peer->srtt = rtt << 3;
+    peer->rttvar = rtt << 1;
+    return;
+  }
+  int delta = rtt - (peer->srtt >> 3);
+  peer->srtt += delta; //srtt = 7/8 srtt + 1/8 rtt
+  if (delta < 0) delta = -delta;
+  peer->rttvar += delta - (peer->rttvar >> 2); //rttvar = 3/4 rttvar + 1/4 |delta|
+}
+
+// srtt + 4 * rttvar, RF69_ACK_TIMEOUT until the first round trip has been measured
+word RFM69::getAckTimeout(byte nodeID)
+{
+  RFM69Peer* peer = getPeer(nodeID);
+  if (!peer || !peer->srtt)
+    return RF69_ACK_TIMEOUT;
+  word timeout = (peer->srtt >> 3) + peer->rttvar;
+  return timeout < RF69_ACK_TIMEOUT_MIN ? RF69_ACK_TIMEOUT_MIN : (timeout > RF69_ACK_TIMEOUT_MAX ? RF69_ACK_TIMEOUT_MAX : timeout);
+}
+
+RFM69Peer* RFM69::getPeer(byte nodeID, bool create)
+{
+#if RF69_PEER_SLOTS
+  RFM69Peer* oldest = &_peers[0];
+  for (byte i = 0; i < RF69_PEER_SLOTS; i++)
+  {
+    if (_peers[i].nodeID == nodeID)
+    {
+      _peers[i].lastUsed = millis();
+      return &_peers[i];
+    }
+    if (!_peers[i].nodeID || (oldest->nodeID && _peers[i].lastUsed < oldest->lastUsed))
+      oldest = &_peers[i];
+  }
+  if (!create)
+    return null;
+  memset(oldest, 0, sizeof(RFM69Peer));
+  oldest->nodeID = nodeID;
+  oldest->lastUsed = millis();
+  return oldest;
+#else
+  return null;
+#endif
+}
+
+#if RF69_SECURITY
+// CCM nonce: sender ID and its frame counter, unique as long as no node ever reuses a counter under the key
+static void securityNonce(byte* nonce, byte sender, uint32_t counter)
+{
+  memset(nonce, 0, RF69_CCM_NONCE_LEN);
+  nonce[0] = sender;
+  nonce[1] = counter >> 24;
+  nonce[2] = counter >> 16;
+  nonce[3] = counter >> 8;
+  nonce[4] = counter;
+}
+#endif
+
+// RSSI as sent back in an ATPC report, 0 is reserved for "no report"
+static int8_t reportedRssi(int rssi)
+{
+  return rssi < -127 ? -127 : (rssi > -1 ? -1 : rssi);
+}
+
+// xorshift32, good enough to spread retries and backoffs
+word RFM69::random16()
+{
+  _rnd ^= _rnd << 13;
+  _rnd ^= _rnd >> 17;
+  _rnd ^= _rnd << 5;
+  return _rnd;
+}
+
+/// Should be polled immediately after sending a packet with ACK request
+/// Other frames queued meanwhile are left in the queue for receiveDone()
+bool RFM69::ACKReceived(byte fromNodeID) {
+  openFrames();
+  updateHop();
+  updateRate();
+  noInterrupts();
+  for (byte i = _rxTail; i != _rxOpened; i++)
+  {
+    RFM69Frame* frame = &_rxQueue[i & (RF69_RX_QUEUE_SIZE - 1)];
+    if ((frame->ctl & RF69_CTL_SENDACK) && (frame->senderID == fromNodeID || fromNodeID == RF69_BROADCAST_ADDR)
+        && (!(frame->ctl & RF69_CTL_SEQ) || (frame->ctl & RF69_CTL_SEQ) == _ackWaitSeq)) //not an ACK of an earlier frame
+
+    {
+      moveToFront(i); //so receiveDone() hands the ACK out next
+      interrupts();
+      return receiveDone();
+    }
+  }
+  interrupts();
+  if (!receiving())
+    receiveBegin();
+  return false;
+}
+
+// Swap the queued frame at index towards the tail, keeping the order of the others
+void RFM69::moveToFront(byte index) {
+  for (byte j = index; j != _rxTail; j--)
+  {
+    RFM69Frame tmp = _rxQueue[j & (RF69_RX_QUEUE_SIZE - 1)];
+    _rxQueue[j & (RF69_RX_QUEUE_SIZE - 1)] = _rxQueue[(byte)(j - 1) & (RF69_RX_QUEUE_SIZE - 1)];
+    _rxQueue[(byte)(j - 1) & (RF69_RX_QUEUE_SIZE - 1)] = tmp;
+  }
+}
+
+// Selective repeat: up to RF69_BULK_WINDOW frames go out back to back, the last one asks for a
+// block ACK telling which arrived, and the next round resends only the missing ones while the window
+// slides past the ones that are in. Gives up after retries rounds without progress.
+// The receiver has to call setBulkBuffer() and keep calling receiveDone() (or popFrame())
+bool RFM69::sendBulk(byte toAddress, const void* buffer, word size, byte retries)
+{
+  byte frame[MAX_DATA_LEN];
+#if RF69_PEER_SLOTS
+  RFM69Peer* peer = getPeer(toAddress, true);
+#else
+  RFM69Peer exchange = RFM69Peer(); //nothing is kept past this call
+  RFM69Peer* peer = &exchange;
+#endif
+  byte chunk = bulkChunk();
+  word frames = size ? (size + chunk - 1) / chunk : 1;
+  byte transfer = ++_bulkTxId;
+  word base = 0; //first frame not yet ACKed
+  byte acked = 0; //frames base+0..7 ACKed out of order
+  word sent = 0; //frames before this index have been on air at least once
+  byte tries = 0;
+  while (base < frames)
+  {
+    word end = base + RF69_BULK_WINDOW < frames ? base + RF69_BULK_WINDOW : frames;
+    word last = base;
+    for (word i = base; i < end; i++)
+      if (!(acked & (1 << (i - base))))
+        last = i;
+    for (word i = base; i <= last; i++)
+    {
+      if (acked & (1 << (i - base)))
+        continue;
+      byte len = i == frames - 1 ? size - i * chunk : chunk;
+      frame[0] = RF69_EXT_BULK | (i == frames - 1 ? RF69_EXT_BULK_LAST : 0);
+      frame[1] = transfer;
+      frame[2] = i;
+      frame[3] = i >> 8;
+      memcpy(frame + 4, (const byte*)buffer + i * chunk, len);
+      if (i < sent)
+      {
+        peer->retries++;
+        _stats.txRetries++;
+      }
+      else
+        sent = i + 1;
+      if (waitDutyCycle(len + 4, _dutyMaxWait) != RF69_TX_OK)
+      {
+        peer->failed++;
+        _stats.txFailures++;
+        return false;
+      }
+      if (accessChannel() != RF69_TX_OK)
+        break; //the unsent rest goes out next round
+      sendFrame(toAddress, frame, len + 4, i == last, false, RF69_CTL_EXT); //requesting the ACK keeps the radio in RX for it
+    }
+
+    unsigned long sentTime = millis();
+    word waitTime = getAckTimeout(toAddress) << (tries < 8 ? tries : 8);
+    if (waitTime > RF69_ACK_TIMEOUT_MAX || waitTime < getAckTimeout(toAddress)) waitTime = RF69_ACK_TIMEOUT_MAX;
+    waitTime += random16() % ((word)RF69_BACKOFF_SLOT << (tries < 8 ? tries : 8));
+    word next;
+    byte bitmap;
+    bool progress = false;
+    do
+    {
+      if (takeBulkAck(toAddress, transfer, &next, &bitmap))
+      {
+        if (next < base || next > frames)
+          continue; //ACK of an earlier round
+        if (!tries)
+          updateRtt(peer, millis() - sentTime);
+        progress = next > base || (bitmap & ~acked);
+        peer->delivered += next - base;
+        base = next;
+        acked = bitmap;
+        break;
+      }
+    } while (millis() - sentTime < waitTime);
+    tries = progress ? 0 : tries + 1;
+    if (tries > retries)
+    {
+      peer->failed++;
+      _stats.txFailures++;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Block ACK for our transfer from fromNodeID, taken out of the queue without disturbing other frames
+bool RFM69::takeBulkAck(byte fromNodeID, byte transfer, word* next, byte* bitmap)
+{
+  openFrames();
+  updateHop();
+  noInterrupts();
+  for (byte i = _rxTail; i != _rxOpened; i++)
+  {
+    RFM69Frame* frame = &_rxQueue[i & (RF69_RX_QUEUE_SIZE - 1)];
+    if ((frame->ctl & RF69_CTL_EXT) && frame->senderID == fromNodeID && frame->datalen >= 5
+        && (frame->data[0] & RF69_EXT_TYPE) == RF69_EXT_BULKACK && frame->data[1] == transfer)
+    {
+      *next = frame->data[2] | (frame->data[3] << 8);
+      *bitmap = frame->data[4];
+      moveToFront(i);
+      _rxTail++;
+      interrupts();
+      return true;
+    }
+  }
+  interrupts();
+  if (!receiving())
+    receiveBegin();
+  return false;
+}
+
+void RFM69::setBulkBuffer(void* buffer, word size) {
+  _bulkBuffer = (byte*)buffer;
+  _bulkSize = size;
+  _bulkFrom = 0;
+  _bulkDone = false;
+}
+
+word RFM69::bulkReceived() {
+  if (!_bulkDone)
+    return 0;
+  _bulkDone = false; //the buffer is free for the next transfer, this one is still ACKed should its sender ask again
+  return _bulkLength;
+}
+
+byte RFM69::bulkSender() {
+  return _bulkFrom;
+}
+
+// Data bytes per sendBulk() frame: what's left of a FIFO sized frame with FEC and security, which
+// both ends have to run alike anyway, after the bulk header and the room startFrame() may take
+byte RFM69::bulkChunk()
+{
+  byte frameMax = MAX_DATA_LEN;
+  if (_fec) frameMax = frameMax / 2 - RF69_FEC_CRC_LEN;
+  if (_secure) frameMax -= RF69_SECURITY_OVERHEAD;
+  return frameMax - 4 - RF69_EXT_RESERVE;
+}
+
+// Frames carrying an extension header the library handles itself, true if the frame was consumed
+bool RFM69::receiveExt(RFM69Frame* frame) {
+  if (!frame->datalen)
+    return false;
+  switch (frame->data[0] & RF69_EXT_TYPE)
+  {
+    case RF69_EXT_BULK: receiveBulk(frame); return true;
+    case RF69_EXT_BULKACK: return true; //late block ACK of a transfer that has already ended
+    case RF69_EXT_FRAG: receiveFragment(frame); return true;
+  }
+  return false;
+}
+
+void RFM69::receiveBulk(RFM69Frame* frame) {
+  if (frame->datalen < 4 || !_bulkBuffer || frame->targetID != _address)
+    return;
+  byte transfer = frame->data[1];
+  word index = frame->data[2] | (frame->data[3] << 8);
+  if (frame->senderID != _bulkFrom || transfer != _bulkId) //start of another transfer
+  {
+    bool unfinished = !_bulkEnd || _bulkNext < _bulkEnd;
+    if (_bulkFrom && (_bulkDone || (unfinished && frame->senderID != _bulkFrom && millis() - _bulkLastRx < RF69_BULK_IDLE)))
+      return; //buffer still holds a transfer the sketch hasn't taken, or another node is mid transfer
+    _bulkFrom = frame->senderID;
+    _bulkId = transfer;
+    _bulkNext = 0;
+    _bulkMap = 0;
+    _bulkEnd = 0;
+  }
+  _bulkLastRx = millis();
+  if (index >= _bulkNext && index - _bulkNext < 8)
+  {
+    unsigned long offset = (unsigned long)index * bulkChunk();
+    byte len = frame->datalen - 4;
+    if (offset + len <= _bulkSize) //else never ACKed, the sender gives up
+    {
+      memcpy(_bulkBuffer + offset, frame->data + 4, len);
+      _bulkMap |= 1 << (index - _bulkNext);
+      if (frame->data[0] & RF69_EXT_BULK_LAST)
+      {
+        _bulkEnd = index + 1;
+        _bulkLength = offset + len;
+      }
+      while (_bulkMap & 1)
+      {
+        _bulkMap >>= 1;
+        _bulkNext++;
+      }
+      if (_bulkEnd && _bulkNext == _bulkEnd)
+        _bulkDone = true;
+    }
+  }
+  if (frame->ctl & RF69_CTL_REQACK)
+  {
+    byte ack[5] = { RF69_EXT_BULKACK, transfer, (byte)_bulkNext, (byte)(_bulkNext >> 8), _bulkMap };
+    if (accessChannel(false) == RF69_TX_OK)
+      sendFrame(frame->senderID, ack, sizeof(ack), false, false, RF69_CTL_EXT);
+    armReceiver(); //the next window follows right away
+  }
+}
+
+// Messages too long for a frame: cut into chunks that fit a frame next to the fragment header and
+// the headers startFrame() may add, each chunk goes through sendWithRetry() in order. Stops at the
+// first fragment that doesn't get through, the receiver drops the partial message after
+// RF69_FRAG_TIMEOUT. The receiver has to call setMessageBuffer() and keep calling receiveDone()
+bool RFM69::sendMessage(byte toAddress, const void* buffer, word size, byte retries)
+{
+  byte frame[RF69_FRAME_DATA_LEN];
+  byte frameMax = _largeFrames ? RF69_LARGE_DATA_LEN : MAX_DATA_LEN;
+  if (frameMax > RF69_FRAME_DATA_LEN) frameMax = RF69_FRAME_DATA_LEN;
+  if (_fec) frameMax = frameMax / 2 - RF69_FEC_CRC_LEN;
+  if (_secure) frameMax -= RF69_SECURITY_OVERHEAD;
+  byte chunk = frameMax - 4 - RF69_EXT_RESERVE;
+  word fragments = size ? (size + chunk - 1) / chunk : 1;
+  if (fragments > RF69_FRAG_MAX || toAddress == RF69_BROADCAST_ADDR)
+    return false;
+  byte id = ++_msgTxId;
+  for (word i = 0; i < fragments; i++)
+  {
+    byte len = i == fragments - 1 ? size - i * chunk : chunk;
+    frame[0] = RF69_EXT_FRAG | (i == fragments - 1 ? RF69_EXT_FRAG_LAST : 0);
+    frame[1] = id;
+    frame[2] = i;
+    frame[3] = chunk;
+    memcpy(frame + 4, (const byte*)buffer + i * chunk, len);
+    if (!sendReliable(toAddress, frame, len + 4, retries, 0, RF69_CTL_EXT))
+      return false;
+  }
+  return true;
+}
+
+// The pool is split into RF69_FRAG_SLOTS equal slots, longer messages are never ACKed
+void RFM69::setMessageBuffer(void* buffer, word size) {
+  _msgBuffer = (byte*)buffer;
+  _msgSlotSize = size / RF69_FRAG_SLOTS;
+  memset(_msgSlots, 0, sizeof(_msgSlots));
+  _msgCurrent = 0xFF;
+}
+
+word RFM69::messageReceived() {
+  if (_msgCurrent != 0xFF)
+    _msgSlots[_msgCurrent].from = 0;
+  _msgCurrent = 0xFF;
+  for (byte i = 0; i < RF69_FRAG_SLOTS; i++)
+    if (_msgSlots[i].from && _msgSlots[i].done)
+    {
+      _msgCurrent = i;
+      return _msgSlots[i].length;
+    }
+  return 0;
+}
+
+const byte* RFM69::messageData() {
+  return _msgCurrent == 0xFF ? null : _msgBuffer + _msgCurrent * _msgSlotSize;
+}
+
+byte RFM69::messageSender() {
+  return _msgCurrent == 0xFF ? 0 : _msgSlots[_msgCurrent].from;
+}
+
+// Fragments are ACKed here once stored, or when the message is already complete. One that finds
+// no slot (all busy with messages that are still coming in or wait for the sketch) isn't,
+// so its sender retries and eventually gives up
+void RFM69::receiveFragment(RFM69Frame* frame) {
+  if (frame->datalen < 4 || !_msgBuffer || frame->targetID != _address)
+    return;
+  byte id = frame->data[1];
+  byte index = frame->data[2];
+  byte chunk = frame->data[3];
+  byte len = frame->datalen - 4;
+  bool last = frame->data[0] & RF69_EXT_FRAG_LAST;
+  unsigned long offset = (unsigned long)index * chunk;
+  if (index >= RF69_FRAG_MAX || !chunk || (!last && len != chunk) || offset + len > _msgSlotSize)
+    return;
+  RFM69Reassembly* slot = null;
+  RFM69Reassembly* spare = null;
+  for (byte i = 0; i < RF69_FRAG_SLOTS; i++)
+  {
+    RFM69Reassembly* s = &_msgSlots[i];
+    if (s->from == frame->senderID && s->id == id)
+      slot = s;
+    else if (!s->from || (!s->done && i != _msgCurrent && millis() - s->lastRx > RF69_FRAG_TIMEOUT))
+      spare = s;
+  }
+  if (!slot)
+  {
+    if (!spare)
+      return;
+    slot = spare;
+    memset(slot, 0, sizeof(RFM69Reassembly));
+    slot->from = frame->senderID;
+    slot->id = id;
+    slot->chunk = chunk;
+    slot->last = 0xFF;
+  }
+  if (chunk != slot->chunk)
+    return;
+  slot->lastRx = millis();
+  if (!slot->done && !(slot->received[index >> 3] & (1 << (index & 7))))
+  {
+    memcpy(_msgBuffer + (slot - _msgSlots) * _msgSlotSize + offset, frame->data + 4, len);
+    slot->received[index >> 3] |= 1 << (index & 7);
+    if (last)
+    {
+      slot->last = index;
+      slot->length = offset + len;
+    }
+    if (slot->last != 0xFF)
+    {
+      byte i = 0;
+      while (i <= slot->last && (slot->received[i >> 3] & (1 << (i & 7))))
+        i++;
+      slot->done = i > slot->last;
+    }
+  }
+  if (frame->ctl & RF69_CTL_REQACK)
+  {
+    if (accessChannel(false) == RF69_TX_OK)
+      sendFrame(frame->senderID, "", 0, false, true, frame->ctl & RF69_CTL_SEQ);
+    armReceiver(); //the next fragment follows right away
+  }
+}
+
+/// Should be called immediately after reception in case sender wants ACK
+byte RFM69::sendACK(const void* buffer, byte bufferSize) {
+  byte sender = SENDERID;
+  byte result = accessChannel(false);
+  if (result == RF69_TX_OK)
+    sendFrame(sender, buffer, bufferSize, false, true, _lastRxSeq);
+  return result;
+}
+
+// ACK a retransmission the duplicate filter dropped, the sender evidently missed our first ACK
+void RFM69::sendPendingACK() {
+  byte seq = _dupAckSeq;
+  if (!seq)
+    return;
+  _dupAckSeq = 0;
+  if (accessChannel(false) == RF69_TX_OK)
+    sendFrame(_dupAckTo, "", 0, false, true, seq);
+}
+
+void RFM69::sendFrame(byte toAddress, const void* buffer, byte bufferSize, bool requestACK, bool sendACK, byte seq)
+{
+  startFrame(toAddress, buffer, bufferSize, requestACK, sendACK, seq);
+  while (_mode == RF69_MODE_TX); //wait for the PacketSent interrupt to end the transmission
+}
+
+void RFM69::startFrame(byte toAddress, const void* buffer, byte bufferSize, bool requestACK, bool sendACK, byte seq)
+{
+  setMode(RF69_MODE_STANDBY); //turn off receiver to prevent reception while filling fifo
+	while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // Wait for ModeReady
+  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_00); // DIO0 is "Packet Sent", DIO1 is "FifoLevel"
+
+  if (_rateBase != 0xFF)
+  {
+    if (sendACK)
+      updateRate(); //a switch the frame we answer asked for
+    else
+    {
+      RFM69Peer* peer = toAddress == RF69_BROADCAST_ADDR ? null : getPeer(toAddress);
+      switchRate(peer && (long)(peer->rateUntil - millis()) > 0 ? peer->rate : _rateBase);
+    }
+  }
+
+  //extension headers the library puts in front of the payload, each only if the payload still fits
+  //beside it, a frame without one just carries no hop phase, wake time or RSSI request/report
+  byte dataMax = _largeFrames ? RF69_LARGE_DATA_LEN : MAX_DATA_LEN; //room for ext headers and payload
+  if ((_fec || _compress || _secure) && dataMax > RF69_FRAME_DATA_LEN)
+    dataMax = RF69_FRAME_DATA_LEN; //they build the frame in a buffer that is FIFO sized without RF69_LARGE_FRAMES
+  if (_fec)
+    dataMax = dataMax / 2 - RF69_FEC_CRC_LEN;
+  if (_secure)
+    dataMax -= RF69_SECURITY_OVERHEAD;
+  byte ext[RF69_EXT_MAX];
+  byte extLen = 0;
+  byte lastExt = 0;
+  if (_hopCount)
+  {
+    _hopLastSync = millis(); //a sender keeps its own hop clock running
+    unsigned long airtime = getAirtime(bufferSize + RF69_EXT_RESERVE);
+    unsigned long into;
+    for (;;)
+    {
+      updateHop();
+      into = (millis() - _hopEpoch) % ((unsigned long)_hopCount * _hopDwell);
+      if (into / _hopDwell != _hopPos)
+        continue; //the dwell ended just now
+      into %= _hopDwell;
+      if ((_hopDwell - into) * 1000 >= airtime || airtime >= _hopDwell * 1000UL)
+        break;
+      unsigned long wait = millis(); //frame would overrun the dwell, wait for the next channel
+      while (millis() - wait < _hopDwell - into);
+    }
+    if (bufferSize + extLen + 2 <= dataMax) //else receivers resync on the next frame
+    {
+      lastExt = extLen;
+      ext[extLen++] = RF69_EXT_HOP;
+      ext[extLen++] = into * 256 / _hopDwell;
+    }
+  }
+  if (_burstEnd && bufferSize + extLen + 3 <= dataMax)
+  {
+    long remaining = _burstEnd - millis();
+    if (remaining < 0) remaining = 0;
+    if (extLen) ext[lastExt] |= RF69_EXT_MORE;
+    lastExt = extLen;
+    ext[extLen++] = RF69_EXT_WAKE;
+    ext[extLen++] = remaining;
+    ext[extLen++] = remaining >> 8;
+  }
+  if (_atpcTarget)
+  {
+    RFM69Peer* peer = toAddress == RF69_BROADCAST_ADDR ? null : getPeer(toAddress);
+    setPowerDBm((_isRFM69HW ? 20 : 13) - (peer ? peer->txBackoff : 0));
+    if (requestACK && toAddress != RF69_BROADCAST_ADDR && !(seq & RF69_CTL_EXT) && bufferSize + extLen + 1 <= dataMax) //sendBulk() frames are answered by block ACKs
+    {
+      if (extLen) ext[lastExt] |= RF69_EXT_MORE;
+      lastExt = extLen;
+      ext[extLen++] = RF69_EXT_RSSI;
+    }
+  }
+  updateDrift();
+  if (_afcOn && !sendACK && toAddress != RF69_BROADCAST_ADDR)
+  {
+    RFM69Peer* peer = getPeer(toAddress);
+    if (peer && peer->freqSamples && peer->freqOffset)
+    {
+      tune(_frf + _frfTrim + peer->freqOffset); //the ISR tunes back once it's sent
+      _txRetuned = true;
+    }
+  }
+  if (_rateTx != 0xFF && bufferSize + extLen + 2 <= dataMax)
+  {
+    if (extLen) ext[lastExt] |= RF69_EXT_MORE;
+    lastExt = extLen;
+    ext[extLen++] = RF69_EXT_RATE;
+    ext[extLen++] = _rateTx;
+  }
+  else
+    _rateTx = 0xFF;
+  if (sendACK && _reportRssi)
+  {
+    if (bufferSize + extLen + 2 <= dataMax)
+    {
+      if (extLen) ext[lastExt] |= RF69_EXT_MORE;
+      lastExt = extLen;
+      ext[extLen++] = RF69_EXT_RSSI | RF69_EXT_REPORT;
+      ext[extLen++] = _reportRssi;
+    }
+    _reportRssi = 0;
+  }
+  bool ownExt = seq & RF69_CTL_EXT; //sendBulk()/sendMessage() frames start with their own header
+  if (extLen)
+  {
+    if (ownExt)
+      ext[lastExt] |= RF69_EXT_MORE; //the caller's own header follows
+    seq |= RF69_CTL_EXT;
+  }
+
+  byte maxLen = dataMax - extLen;
+  if (bufferSize > maxLen) bufferSize = maxLen;
+#if RF69_COMPRESSION
+  if (_compress && !ownExt) //the receiver strips the library's headers before it expands the rest
+  {
+    byte packed = lzCompress(_lzBuf, buffer, bufferSize);
+    if (packed) //else it goes out as it is
+    {
+      buffer = _lzBuf;
+      bufferSize = packed;
+      seq |= RF69_CTL_LZ;
+    }
+  }
+#endif
+  byte ctl = sendACK ? RF69_CTL_SENDACK | seq : (requestACK ? RF69_CTL_REQACK | seq : seq);
+#if RF69_SECURITY
+  if (_secure) //frame counter in the clear, then ext headers and payload encrypted, then the MIC
+  {
+    byte nonce[RF69_CCM_NONCE_LEN];
+    securityNonce(nonce, _address, _txCounter);
+    byte header[3] = { toAddress, _address, ctl };
+    memcpy(_secBuf, nonce + 1, 4);
+    memcpy(_secBuf + 4, ext, extLen);
+    memcpy(_secBuf + 4 + extLen, buffer, bufferSize);
+    bufferSize += extLen;
+    ccmSeal(RF69_AES, _secKey, nonce, header, 3, _secBuf + 4, bufferSize, _secBuf + 4 + bufferSize);
+    bufferSize += RF69_SECURITY_OVERHEAD;
+    buffer = _secBuf;
+    extLen = 0;
+    _txCounter++; //every frame, retransmissions too, the duplicate filter goes by the sequence number
+  }
+#endif
+#if RF69_FEC
+  if (_fec) //ext headers, payload and a CRC over all of it with the header go out coded as one block
+  {
+    byte header[3] = { toAddress, _address, ctl };
+    word crc = fecCrc(fecCrc(fecCrc(0xFFFF, header, 3), ext, extLen), buffer, bufferSize);
+    byte trailer[RF69_FEC_CRC_LEN] = { (byte)(crc >> 8), (byte)crc };
+    byte* end = fecEncode(fecEncode(fecEncode(_fecBuf, ext, extLen), buffer, bufferSize), trailer, RF69_FEC_CRC_LEN);
+    bufferSize = end - _fecBuf;
+    fecInterleave(_fecBuf, bufferSize);
+    buffer = _fecBuf;
+    extLen = 0;
+  }
+#endif
+  //the FIFO takes the length byte, header and up to 62 bytes of payload, the ISR streams in the rest of a large frame
+  byte fifoLen = bufferSize > RF69_FIFO_SIZE - 4 - extLen ? RF69_FIFO_SIZE - 4 - extLen : bufferSize;
+  _txNext = (const byte*)buffer + fifoLen;
+  _txLeft = bufferSize - fifoLen;
+  unsigned long airtime = _dutyPermille ? frameAirtime(bufferSize + extLen) : 0; //what goes on air, headers, MIC and coding included
+
+	//write to FIFO
+	select();
+	SPI.transfer(REG_FIFO | 0x80);
+	SPI.transfer(bufferSize + extLen + 3);
+	SPI.transfer(toAddress);
+  SPI.transfer(_address);
+  
+  SPI.transfer(ctl);
+  for (byte i = 0; i < extLen; i++)
+    SPI.transfer(ext[i]);
+  
+	for (byte i = 0; i < fifoLen; i++)
+    SPI.transfer(((byte*)buffer)[i]);
+	unselect();
+
+	/* no need to wait for transmit mode to be ready since its handled by the radio */
+  _stats.txFrames++;
+  if (_dutyPermille)
+  {
+    refillDutyCycle();
+    _dutyTokens -= airtime;
+  }
+  _txAckRequested = requestACK;
+  if (requestACK)
+    _ackWaitSeq = seq & RF69_CTL_SEQ;
+	setMode(RF69_MODE_TX);
+}
+
+// Serves DIO0 (PacketSent/PayloadReady) and, with setLargeFrames(), DIO1 (FifoLevel).
+// Received frames are drained into the next free slot of the receive queue.
+// The radio is left in RX: with AutoRxRestartOn the receiver rearms itself as soon
+// as the FIFO is empty, so back-to-back frames are caught while earlier ones wait in the queue
+void RFM69::interruptHandler() {
+  //pinMode(4, OUTPUT);
+  //digitalWrite(4, 1);
+  byte irqFlags = readReg(REG_IRQFLAGS2);
+  //DIO0 (PacketSent/PayloadReady) rose, stamp it before the FIFO is drained
+  unsigned long stamp = irqFlags & (RF_IRQFLAGS2_PACKETSENT | RF_IRQFLAGS2_PAYLOADREADY) ? timestampEdge(_interruptNum) : 0;
+  if (_mode == RF69_MODE_TX)
+  {
+    if (_txLeft && !(irqFlags & RF_IRQFLAGS2_FIFOLEVEL)) //FIFO down to the threshold, top it up
+    {
+      byte n = _txLeft < RF69_FIFO_SIZE - RF69_FIFO_THRESHOLD - 1 ? _txLeft : RF69_FIFO_SIZE - RF69_FIFO_THRESHOLD - 1;
+      _txLeft -= n;
+      select();
+      SPI.transfer(REG_FIFO | 0x80);
+      while (n--)
+        SPI.transfer(*_txNext++);
+      unselect();
+    }
+    if (irqFlags & RF_IRQFLAGS2_PACKETSENT)
+    {
+      _txTimestamp = stamp;
+      if (_txRetuned)
+      {
+        _txRetuned = false;
+        tune(_frf + _frfTrim);
+      }
+      if (_txAckRequested)
+        armReceiver(); //go straight to RX so the ACK can't slip by before the sketch polls for it
+      else
+        setMode(RF69_MODE_STANDBY);
+      if (_sendDoneCallback)
+        _sendDoneCallback();
+    }
+    return;
+  }
+
+  bool payloadReady = irqFlags & RF_IRQFLAGS2_PAYLOADREADY;
+  bool crcOk = _fec || (irqFlags & RF_IRQFLAGS2_CRCOK); //with FEC the radio's CRC is off, decodeFrame() checks its own
+  if (!receiving() || !(payloadReady || (_largeFrames && (irqFlags & RF_IRQFLAGS2_FIFOLEVEL))))
+    return;
+  _stats.rxWakeups++;
+  RFM69Frame* frame = &_rxQueue[_rxHead & (RF69_RX_QUEUE_SIZE - 1)];
+  byte avail = RF69_FIFO_THRESHOLD; //on FifoLevel at least this many bytes are waiting, PayloadReady means the whole frame
+  if (!_rxStreaming) //start of a new frame
+  {
+    if (payloadReady && !crcOk)
+    {
+      _stats.rxCrcErrors++;
+      dropFrame(payloadReady);
+      return;
+    }
+    if ((byte)(_rxHead - _rxTail) >= RF69_RX_QUEUE_SIZE) //queue full, sketch is not keeping up
+    {
+      _stats.rxOverflows++;
+      dropFrame(payloadReady);
+      return;
+    }
+#if DISABLE_RSSI_CHECK
+    frame->rssi = 0;
+#else
+    frame->rssi = readRSSI(); //sample before the receiver restarts
+#endif
+    frame->afc = 0;
+    if (_afcOn) //cleared when the receiver restarts too
+    {
+      byte afc[2];
+      readRegBurst(REG_AFCMSB, afc, 2);
+      frame->afc = (afc[0] << 8) | afc[1];
+    }
+    frame->rssiRequested = false;
+    select();
+    SPI.transfer(REG_FIFO & 0x7f);
+    byte payloadLen = SPI.transfer(0);
+    frame->targetID = SPI.transfer(0);
+    bool drop = true;
+    if(!(_promiscuousMode || frame->targetID==_address || frame->targetID==RF69_BROADCAST_ADDR)) //match this node's address, or broadcast address or anything in promiscuous mode
+      _stats.rxAddressMismatch++;
+    else if (payloadLen < 3 //payload too short?
+       || payloadLen - 3 > RF69_FRAME_DATA_LEN) //or too long for the queue slots
+      _stats.rxBadLength++;
+    else drop = false;
+    if (drop)
+    {
+      unselect();
+      dropFrame(payloadReady);
+      //digitalWrite(4, 0);
+      return;
+    }
+    frame->senderID = SPI.transfer(0);
+    frame->ctl = SPI.transfer(0);
+#if RF69_DUPLICATE_FILTER
+    byte seq = frame->ctl & RF69_CTL_SEQ;
+    //ACKs echo the sequence number, they are never duplicates. Secured frames wait for acceptFrame(),
+    //a forged header must not be counted or ACKed before the MIC is checked
+    if (seq && !_secure && frame->targetID == _address && !(frame->ctl & RF69_CTL_SENDACK))
+    {
+      if (isDuplicate(frame->senderID, seq)) //retransmission of a frame we already have
+      {
+        unselect();
+        dropFrame(payloadReady);
+        _stats.rxDuplicates++;
+        if (frame->ctl & RF69_CTL_REQACK)
+        {
+          _dupAckTo = frame->senderID;
+          _dupAckSeq = seq;
+        }
+        return;
+      }
+    }
+#endif
+    frame->datalen = 0;
+    _rxLeft = payloadLen - 3;
+    _rxStreaming = true;
+    avail -= 4;
+  }
+  else
+  {
+    select();
+    SPI.transfer(REG_FIFO & 0x7f);
+  }
+  byte n = payloadReady || _rxLeft < avail ? _rxLeft : avail;
+  _rxLeft -= n;
+  while (n--)
+    frame->data[frame->datalen++] = SPI.transfer(0);
+  unselect();
+  if (payloadReady)
+  {
+    _rxStreaming = false;
+    frame->timestamp = stamp;
+    if (!crcOk) //only known now for a frame streamed in on FifoLevel
+    {
+      _stats.rxCrcErrors++;
+      return;
+    }
+    _rxHead++; //decoding, the MIC and ext headers are left to openFrames()
+  }
+  //digitalWrite(4, 0);
+}
+
+// Throw away the frame being received. Part way through a large frame the receiver is restarted too,
+// otherwise the rest of the frame would land in the FIFO and be taken for a new one
+void RFM69::dropFrame(bool payloadReady) {
+  _rxStreaming = false;
+  clearFIFO();
+  if (!payloadReady)
+    writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART);
+}
+
+void RFM69::attachIsr(byte interruptNum, int mode) {
+  _irqOwner[interruptNum] = this;
+  attachInterrupt(interruptNum, interruptNum == 0 ? RFM69::isr0 : (interruptNum == 1 ? RFM69::isr1 : RFM69::isr2), mode);
+}
+
+void RFM69::isr0() { _irqOwner[0]->interruptHandler(); }
+void RFM69::isr1() { _irqOwner[1]->interruptHandler(); }
+void RFM69::isr2() { _irqOwner[2]->interruptHandler(); }
+
+void RFM69::receiveStart() {
+  if (!receiving())
+  {
+    receiveBegin();
+  }
+}
+
+// Discard whatever is left in the FIFO, the receiver then rearms for the next frame
+void RFM69::clearFIFO() {
+  writeReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN);
+}
+
+void RFM69::receiveBegin() {
+  DATALEN = 0;
+  SENDERID = 0;
+  TARGETID = 0;
+  PAYLOADLEN = 0;
+  ACK_REQUESTED = 0;
+  ACK_RECEIVED = 0;
+  RSSI = 0;
+  armReceiver();
+}
+
+// Switch to RX without touching DATA/SENDERID etc, so it is safe from the ISR
+void RFM69::armReceiver() {
+  if (_rxStreaming) //left RX part way through a large frame
+    dropFrame(true);
+  if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)
+    writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
+  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01); //set DIO0 to "PAYLOADREADY" in receive mode
+  setMode(RF69_MODE_RX);
+}
+
+// Moves the oldest queued frame into DATA/DATALEN/SENDERID etc.
+// The radio stays in RX so further frames keep queueing while the sketch processes this one
+bool RFM69::receiveDone() {
+  openFrames(); //may find a retransmission to ACK again
+  sendPendingACK();
+  RFM69Frame* frame = peekFrame();
+  noInterrupts();
+  if (frame)
+  {
+    DATALEN = frame->datalen;
+    PAYLOADLEN = frame->datalen + 3;
+    SENDERID = frame->senderID;
+    TARGETID = frame->targetID;
+    ACK_RECEIVED = frame->ctl & RF69_CTL_SENDACK; //extract ACK-received flag
+    ACK_REQUESTED = frame->ctl & RF69_CTL_REQACK; //extract ACK-requested flag
+    _lastRxSeq = frame->ctl & RF69_CTL_SEQ;
+    _reportRssi = frame->rssiRequested ? reportedRssi(frame->rssi) : 0;
+    RSSI = frame->rssi;
+    TIMESTAMP = frame->timestamp;
+    FREQERROR = (long)frame->afc * 15625 / 256; //FSTEP = 15625 / 256 Hz
+    learnOffset(*frame);
+    if (_receiveCallback && !ACK_RECEIVED) //ACKs stay with ACKReceived()/DATA
+    {
+      interrupts(); //the ISR leaves the slot alone until _rxTail moves past it
+      _receiveCallback(*frame);
+      _rxTail++;
+      return true;
+    }
+    bool own = _rxBuffer && !ACK_RECEIVED; //ACK payloads stay in DATA for ACKReceived() callers
+    byte* dest = own ? _rxBuffer : (byte*)DATA;
+    byte n = own && DATALEN > _rxBufferSize ? _rxBufferSize : DATALEN;
+    for (byte i = 0; i < n; i++)
+      dest[i] = frame->data[i];
+    _rxTail++;
+    interrupts();
+    return true;
+  }
+  interrupts();
+  if (!receiving())
+    receiveBegin();
+  return false;
+}
+
+// Also sets SENDERID so sendACK() works the same as after receiveDone()
+bool RFM69::popFrame(RFM69Frame& frame) {
+  openFrames();
+  sendPendingACK();
+  RFM69Frame* next = peekFrame();
+  noInterrupts();
+  if (!next)
+  {
+    interrupts();
+    if (!receiving())
+      receiveBegin();
+    return false;
+  }
+  frame = *next;
+  _rxTail++;
+  SENDERID = frame.senderID;
+  _lastRxSeq = frame.ctl & RF69_CTL_SEQ;
+  _reportRssi = frame.rssiRequested ? reportedRssi(frame.rssi) : 0;
+  interrupts();
+  learnOffset(frame);
+  return true;
+}
+
+// Everything after the CRC for frames the ISR queued, in the sketch's context: software AES-CCM
+// alone is ~11 block encryptions per frame, too long for an ISR. Frames that fail are dropped from
+// the queue; the ISR only writes the slot at _rxHead, so the others can be moved without it
+void RFM69::openFrames() {
+  if (_mode == RF69_MODE_TX)
+    return; //a large compressed frame may still be streaming out of _lzBuf
+  while (_rxOpened != _rxHead)
+  {
+    if (!acceptFrame(&_rxQueue[_rxOpened & (RF69_RX_QUEUE_SIZE - 1)]))
+    {
+      moveToFront(_rxOpened);
+      _rxTail++;
+    }
+    _rxOpened++;
+  }
+}
+
+bool RFM69::acceptFrame(RFM69Frame* frame) {
+  if (_fec && !decodeFrame(frame))
+  {
+    _stats.rxCrcErrors++;
+    return false;
+  }
+  if (_secure && !openFrame(frame)) //before anything in it is believed, the sequence number too
+    return false;
+#if RF69_DUPLICATE_FILTER
+  byte seq = frame->ctl & RF69_CTL_SEQ;
+  if (seq && !_secure && frame->targetID == _address && !(frame->ctl & RF69_CTL_SENDACK))
+  {
+    if (isDuplicate(frame->senderID, seq)) //queued before the first copy was opened here
+    {
+      _stats.rxDuplicates++;
+      if (frame->ctl & RF69_CTL_REQACK)
+      {
+        noInterrupts();
+        _dupAckTo = frame->senderID;
+        _dupAckSeq = seq;
+        interrupts();
+      }
+      return false;
+    }
+    //remember the sequence number only for good frames, a corrupted one must not get a retransmission dropped
+    rememberSeq(frame->senderID, seq);
+  }
+#endif
+  if (frame->targetID == _address)
+    _rateHoldUntil = millis() + RF69_RATE_HOLD; //a link off the base rate is still in use
+  if (frame->ctl & RF69_CTL_EXT)
+    receiveHeaders(frame);
+  if ((frame->ctl & RF69_CTL_LZ) && !expandFrame(frame))
+  {
+    _stats.rxBadLength++;
+    return false;
+  }
+  _stats.rxFrames++;
+  return true;
+}
+
+// Oldest queued frame for the sketch, frames the library handles itself are processed on the way
+RFM69Frame* RFM69::peekFrame() {
+  openFrames();
+  updateHop();
+  updateRate();
+  while (_rxOpened != _rxTail)
+  {
+    RFM69Frame* frame = &_rxQueue[_rxTail & (RF69_RX_QUEUE_SIZE - 1)];
+    if (!(frame->ctl & RF69_CTL_EXT) || !receiveExt(frame))
+      return frame;
+    _rxTail++;
+  }
+  return null;
+}
+
+byte RFM69::framesPending() {
+  openFrames();
+  return _rxHead - _rxTail;
+}
+
+word RFM69::getRxOverflows() {
+  return (word)_stats.rxOverflows;
+}
+
+word RFM69::getRxDuplicates() {
+  return (word)_stats.rxDuplicates;
+}
+
+void RFM69::getStats(RFM69Stats& stats) {
+  noInterrupts();
+  stats = _stats;
+  stats.modeTime[_mode] += millis() - _modeSince; //the current mode up to now
+  interrupts();
+}
+
+void RFM69::resetStats() {
+  noInterrupts();
+  memset(&_stats, 0, sizeof(_stats));
+  _modeSince = millis();
+  interrupts();
+}
+
+// Compact binary dump for a host script, 2 + sizeof(RFM69Stats) bytes
+void RFM69::dumpStats() {
+  RFM69Stats stats;
+  getStats(stats);
+  Serial.write('S');
+  Serial.write((byte)sizeof(stats));
+  Serial.write((const uint8_t*)&stats, sizeof(stats));
+}
+
+// To enable encryption: radio.encrypt("ABCDEFGHIJKLMNOP");
+// To disable encryption: radio.encrypt(null) or radio.encrypt(0)
+// KEY HAS TO BE 16 bytes !!!
+// Not available with setLargeFrames(), AES only works on frames that fit the FIFO, nor with setFec()
+// or setSecurity(). ECB leaves equal blocks equal and captured frames can be replayed, see setSecurity()
+void RFM69::encrypt(const char* key) {
+  if (key && (_largeFrames || _fec || _secure)) return;
+  setMode(RF69_MODE_STANDBY);
+  if (key!=0)
+    writeRegBurst(REG_AESKEY1, key, 16);
+  writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFE) | (key ? 1 : 0));
+}
+
+int RFM69::readRSSI(bool forceTrigger) {
+  int rssi = 0;
+  if (forceTrigger)
+  {
+    //RSSI trigger not needed if DAGC is in continuous mode
+    writeReg(REG_RSSICONFIG, RF_RSSI_START);
+    while ((readReg(REG_RSSICONFIG) & RF_RSSI_DONE) == 0x00); // Wait for RSSI_Ready
+  }
+  rssi = -readReg(REG_RSSIVALUE);
+  rssi >>= 1;
+  return rssi;
+}
+
+byte RFM69::readReg(byte addr)
+{
+  if (isShadowed(addr) && (_shadowValid[addr >> 3] & (1 << (addr & 7))))
+    return _shadow[addr];
+  return readRegDirect(addr);
+}
+
+byte RFM69::readRegDirect(byte addr)
+{
+  select();
+  SPI.transfer(addr & 0x7F);
+  byte regval = SPI.transfer(0);
+  if (isShadowed(addr))
+  {
+    _shadow[addr] = regval;
+    _shadowValid[addr >> 3] |= 1 << (addr & 7);
+  }
+  unselect();
+  return regval;
+}
+
+void RFM69::writeReg(byte addr, byte value)
+{
+  if (isShadowed(addr))
+  {
+    byte trigger = shadowTrigger(addr);
+    noInterrupts(); //re-enabled in unselect()
+    if (!(value & trigger) && (_shadowValid[addr >> 3] & (1 << (addr & 7))) && _shadow[addr] == value)
+    {
+      interrupts();
+      return;
+    }
+    _shadow[addr] = value & ~trigger;
+    _shadowValid[addr >> 3] |= 1 << (addr & 7);
+  }
+  select();
+  SPI.transfer(addr | 0x80);
+  SPI.transfer(value);
+  unselect();
+}
+
+// The address auto-increments in burst mode, so this programs len registers from addr on
+// Don't start at REG_FIFO, which doesn't increment
+void RFM69::writeRegBurst(byte addr, const void* buffer, byte len)
+{
+  select();
+  SPI.transfer(addr | 0x80);
+  for (byte i = 0; i < len; i++, addr++)
+  {
+    byte value = ((const byte*)buffer)[i];
+    if (isShadowed(addr))
+    {
+      _shadow[addr] = value & ~shadowTrigger(addr);
+      _shadowValid[addr >> 3] |= 1 << (addr & 7);
+    }
+    SPI.transfer(value);
+  }
+  unselect();
+}
+
+void RFM69::readRegBurst(byte addr, void* buffer, byte len)
+{
+  select();
+  SPI.transfer(addr & 0x7F);
+  for (byte i = 0; i < len; i++, addr++)
+  {
+    byte value = SPI.transfer(0);
+    if (isShadowed(addr))
+    {
+      _shadow[addr] = value;
+      _shadowValid[addr >> 3] |= 1 << (addr & 7);
+    }
+    ((byte*)buffer)[i] = value;
+  }
+  unselect();
+}
+
+// buffer[0] is REG_OPMODE (0x01), buffer[RF69_REG_SNAPSHOT_SIZE-1] is REG_TEMP2 (0x4F)
+void RFM69::snapshotRegs(byte* buffer)
+{
+  readRegBurst(REG_OPMODE, buffer, RF69_REG_SNAPSHOT_SIZE);
+}
+
+unsigned long RFM69::getSpiTransactions() {
+  return _spiTransactions;
+}
+
+/// Select the transceiver
+void RFM69::select() {
+  noInterrupts();
+  _spiTransactions++;
+  digitalWrite(_slaveSelectPin, LOW);
+}
+
+/// UNselect the transceiver chip
+void RFM69::unselect() {
+  digitalWrite(_slaveSelectPin, HIGH);
+  interrupts();
+}
+
+// ON  = disable filtering to capture all frames on network
+// OFF = enable node+broadcast filtering to capture only frames sent to this/broadcast address
+// The filtering is done by the radio, frames for other nodes never raise PayloadReady
 void RFM69::promiscuous(bool onOff) {
   _promiscuousMode=onOff;
-  //writeReg(REG_PACKETCONFIG1, (readReg(REG_PACKETCONFIG1) & 0xF9) | (onOff ? RF_PACKET1_ADRSFILTERING_OFF : RF_PACKET1_ADRSFILTERING_NODEBROADCAST));
+  writeReg(REG_PACKETCONFIG1, (readReg(REG_PACKETCONFIG1) & 0xF9) | (onOff ? RF_PACKET1_ADRSFILTERING_OFF : RF_PACKET1_ADRSFILTERING_NODEBROADCAST));
 }
 
 void RFM69::setHighPower(bool onOff) {
   _isRFM69HW = onOff;
+  _paBoost = true;
   writeReg(REG_OCP, _isRFM69HW ? RF_OCP_OFF : RF_OCP_ON);
   if (_isRFM69HW) //turning ON
     writeReg(REG_PALEVEL, (readReg(REG_PALEVEL) & 0x1F) | RF_PALEVEL_PA1_ON | RF_PALEVEL_PA2_ON); //enable P1 & P2 amplifier stages
@@ -407,6 +2310,187 @@ void RFM69::setHighPower(bool onOff) {
     writeReg(REG_PALEVEL, RF_PALEVEL_PA0_ON | RF_PALEVEL_PA1_OFF | RF_PALEVEL_PA2_OFF | _powerLevel); //enable P0 only
 }
 
+// Large frames carry up to RF69_LARGE_DATA_LEN bytes, cutting per-frame preamble/sync/header/ACK overhead for bulk data.
+// Only the first 62 payload bytes fit the FIFO, the ISR refills (TX) or drains (RX) it on FifoLevel interrupts,
+// so DIO1 has to be wired to external interrupt fifoInterruptNum. Turns AES off.
+// Receivers need RF69_LARGE_FRAMES 1 to keep frames longer than MAX_DATA_LEN.
+bool RFM69::setLargeFrames(bool onOff, byte fifoInterruptNum) {
+  if (onOff && (fifoInterruptNum >= RF69_MAX_IRQ || fifoInterruptNum == _interruptNum))
+    return false;
+  setMode(RF69_MODE_STANDBY);
+  if (_largeFrames)
+    detachInterrupt(_fifoInterruptNum);
+  if (onOff)
+  {
+    encrypt(0);
+    _fifoInterruptNum = fifoInterruptNum;
+    attachIsr(_fifoInterruptNum, CHANGE); //falling edge refills in TX, rising edge drains in RX
+  }
+  _largeFrames = onOff;
+  writeReg(REG_PAYLOADLENGTH, onOff ? 255 : 66);
+  writeReg(REG_FIFOTHRESH, RF_FIFOTHRESH_TXSTART_FIFONOTEMPTY | (onOff ? RF69_FIFO_THRESHOLD : RF_FIFOTHRESH_VALUE));
+  return true;
+}
+
+// FEC codes the ext headers, payload and a CRC-16 over them and the frame header (RFM69fec.h),
+// in place of the radio's CRC: frames with a few bit errors, in bursts of up to 8 bits, are repaired
+// instead of resent. A frame then carries (MAX_DATA_LEN or RF69_LARGE_DATA_LEN) / 2 - 2 bytes,
+// so sendBulk() needs setLargeFrames() too. Turns AES off, its blocks would spread every bit error
+bool RFM69::setFec(bool onOff) {
+#if RF69_FEC
+  setMode(RF69_MODE_STANDBY);
+  if (onOff)
+    encrypt(0);
+  _fec = onOff;
+  writeReg(REG_PACKETCONFIG1, (readReg(REG_PACKETCONFIG1) & ~RF_PACKET1_CRC_ON) | (onOff ? RF_PACKET1_CRC_OFF : RF_PACKET1_CRC_ON));
+  return true;
+#else
+  return !onOff;
+#endif
+}
+
+// Undo the interleaving and coding of a frame in its queue slot and check the CRC
+bool RFM69::decodeFrame(RFM69Frame* frame) {
+#if RF69_FEC
+  byte len = frame->datalen;
+  if (len & 1 || len < RF69_FEC_CODED_LEN(0))
+    return false;
+  fecInterleave(frame->data, len);
+  int corrected = fecDecode(frame->data, frame->data, len);
+  if (corrected < 0)
+    return false;
+  len = len / 2 - RF69_FEC_CRC_LEN;
+  byte header[3] = { frame->targetID, frame->senderID, frame->ctl };
+  word crc = fecCrc(fecCrc(0xFFFF, header, 3), frame->data, len);
+  if (frame->data[len] != (byte)(crc >> 8) || frame->data[len + 1] != (byte)crc)
+    return false;
+  frame->datalen = len;
+  _stats.rxFecCorrected += corrected;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Every payload without a header of its own (so not sendBulk() or sendMessage() ones) is run
+// through the compressor of RFM69lz.h and goes out compressed, flagged RF69_CTL_LZ, whenever
+// that saves airtime; the rest goes out as it is. Receivers expand flagged frames in openFrames()
+// if built with RF69_COMPRESSION, else they drop them. Takes effect with the next frame
+bool RFM69::setCompression(bool onOff) {
+#if RF69_COMPRESSION
+  _compress = onOff;
+  return true;
+#else
+  return !onOff;
+#endif
+}
+
+// Expand a compressed payload in its queue slot
+bool RFM69::expandFrame(RFM69Frame* frame) {
+#if RF69_COMPRESSION
+  int len = lzExpand(_lzBuf, RF69_FRAME_DATA_LEN, frame->data, frame->datalen);
+  if (len < 0)
+    return false;
+  memcpy(frame->data, _lzBuf, len);
+  frame->datalen = len;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// AES-CCM on every frame in place of the radio's AES-ECB (RFM69ccm.h): a 4 byte frame counter goes out
+// in the clear, ext headers and payload encrypted under a nonce made of sender and counter, then a 4 byte
+// MIC over all of it and the target/sender/control bytes. Receivers drop frames whose MIC doesn't match
+// and, per sender, counters they already accepted or that are more than 31 behind the highest one.
+// A node must never send two frames with the same counter under one key: save getFrameCounter()
+// (or a bound ahead of it) somewhere that survives a reset and pass it back in here. Replay windows
+// are lost with a reset and for senders pushed out of the RF69_SECURE_PEERS table.
+// Uses the AES peripheral where the port has one (HAVE_AES_ENGINE), software AES elsewhere, for received
+// frames in receiveDone()/popFrame() rather than the ISR (see the SecurityBenchmark example for the cost per frame). Turns the radio's AES off
+bool RFM69::setSecurity(const void* key, uint32_t frameCounter) {
+#if RF69_SECURITY
+  setMode(RF69_MODE_STANDBY);
+  encrypt(0);
+  _secure = key != null;
+  if (key)
+    memcpy(_secKey, key, 16);
+  _txCounter = frameCounter;
+  memset(_replay, 0, sizeof(_replay));
+  return true;
+#else
+  return !key;
+#endif
+}
+
+uint32_t RFM69::getFrameCounter() {
+#if RF69_SECURITY
+  return _txCounter;
+#else
+  return 0;
+#endif
+}
+
+// Check the MIC and the sender's replay window of a frame in its queue slot and decrypt it.
+// The window only moves for frames that pass the MIC, forged frames can't push genuine ones out
+bool RFM69::openFrame(RFM69Frame* frame) {
+#if RF69_SECURITY
+  if (frame->datalen < RF69_SECURITY_OVERHEAD)
+  {
+    _stats.rxAuthFailures++;
+    return false;
+  }
+  uint32_t counter = ((uint32_t)frame->data[0] << 24) | ((uint32_t)frame->data[1] << 16) | ((word)frame->data[2] << 8) | frame->data[3];
+  RFM69Replay* replay = &_replay[0];
+  for (byte i = 0; i < RF69_SECURE_PEERS; i++)
+  {
+    if (_replay[i].nodeID == frame->senderID)
+    {
+      replay = &_replay[i];
+      break;
+    }
+    if (!_replay[i].nodeID || (replay->nodeID && _replay[i].lastUsed < replay->lastUsed))
+      replay = &_replay[i];
+  }
+  bool known = replay->nodeID == frame->senderID;
+  uint32_t behind = replay->counter - counter;
+  if (known && (int32_t)behind >= 0 && (behind >= 32 || (replay->window >> behind) & 1))
+  {
+    _stats.rxReplays++;
+    return false;
+  }
+  byte nonce[RF69_CCM_NONCE_LEN];
+  securityNonce(nonce, frame->senderID, counter);
+  byte header[3] = { frame->targetID, frame->senderID, frame->ctl };
+  byte len = frame->datalen - RF69_SECURITY_OVERHEAD;
+  if (!ccmOpen(RF69_AES, _secKey, nonce, header, 3, frame->data + 4, len, frame->data + 4 + len))
+  {
+    _stats.rxAuthFailures++;
+    return false;
+  }
+  if (!known)
+  {
+    replay->nodeID = frame->senderID;
+    replay->counter = counter;
+    replay->window = 1;
+  }
+  else if ((int32_t)behind < 0) //newer than any before, slide the window up
+  {
+    uint32_t ahead = -behind;
+    replay->window = ahead >= 32 ? 1 : (replay->window << ahead) | 1;
+    replay->counter = counter;
+  }
+  else
+    replay->window |= (uint32_t)1 << behind;
+  replay->lastUsed = millis();
+  frame->datalen = len;
+  memmove(frame->data, frame->data + 4, len);
+  return true;
+#else
+  return false;
+#endif
+}
+
 void RFM69::setHighPowerRegs(bool onOff) {
   writeReg(REG_TESTPA1, onOff ? 0x5D : 0x55);
   writeReg(REG_TESTPA2, onOff ? 0x7C : 0x70);
@@ -420,14 +2504,12 @@ void RFM69::setCS(byte newSPISlaveSelect) {
 //for debugging
 void RFM69::readAllRegs()
 {
-  byte regVal;
-	
-  for (byte regAddr = 1; regAddr <= 0x4F; regAddr++)
+  byte regs[RF69_REG_SNAPSHOT_SIZE];
+  snapshotRegs(regs); //capture the map in one go, printing it is what takes time
+
+  for (byte regAddr = 1; regAddr <= RF69_REG_SNAPSHOT_SIZE; regAddr++)
 	{
-    select();
-    SPI.transfer(regAddr & 0x7f);	// send address + r/w bit
-    regVal = SPI.transfer(0);
-    unselect();
+    byte regVal = regs[regAddr - 1];
 
     Serial.print(regAddr, HEX);
     Serial.print(" - ");
@@ -435,14 +2517,13 @@ void RFM69::readAllRegs()
     Serial.print(" - ");
     Serial.println(regVal,BIN);
 	}
-  unselect();
 }
 
 byte RFM69::readTemperature(byte calFactor)  //returns centigrade
 {
   setMode(RF69_MODE_STANDBY);
   writeReg(REG_TEMP1, RF_TEMP1_MEAS_START);
-  while ((readReg(REG_TEMP1) & RF_TEMP1_MEAS_RUNNING)) Serial.print('*');
+  while ((readReg(REG_TEMP1) & RF_TEMP1_MEAS_RUNNING));
   return ~readReg(REG_TEMP2) + COURSE_TEMP_COEF + calFactor; //'complement'corrects the slope, rising temp = rising val
 }												   	  // COURSE_TEMP_COEF puts reading in the ballpark, user can add additional correction
 
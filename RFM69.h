@@ -13,14 +13,36 @@
 #define DISABLE_RSSI_CHECK  0
 
 #define MAX_DATA_LEN         61 // to take advantage of the built in AES/CRC we want to limit the frame size to the internal FIFO size (66 bytes - 3 bytes overhead)
+#define RF69_LARGE_DATA_LEN 252 // with setLargeFrames(): 255 max length byte - 3 bytes overhead, AES has to be off
+#ifndef RF69_LARGE_FRAMES
+#define RF69_LARGE_FRAMES     0 // 1 = size DATA and the receive queue for large frames, otherwise they're dropped on reception
+#endif
+#if RF69_LARGE_FRAMES
+#define RF69_FRAME_DATA_LEN RF69_LARGE_DATA_LEN
+#else
+#define RF69_FRAME_DATA_LEN MAX_DATA_LEN
+#endif
+#define RF69_FIFO_SIZE       66
+#define RF69_FIFO_THRESHOLD  32 // FifoLevel threshold, DIO1 interrupts when streaming large frames through the FIFO
 #define SPI_CS               SS // SS is the SPI slave select pin, for instance D10 on atmega328
 #define RF69_IRQ_PIN          2 // INT0 on AVRs should be connected to DIO0 (ex on Atmega328 it's D2)
+#define RF69_IRQ_NUM          0 // external interrupt number of RF69_IRQ_PIN (INT0)
+#define RF69_MAX_IRQ          3 // each radio needs its own external interrupt, numbered 0..RF69_MAX_IRQ-1
+#define RF69_FXOSC_MHZ       32 // crystal, bitrate = FXOSC / REG_BITRATE
 #define CSMA_LIMIT          -90 // upper RX signal sensitivity threshold in dBm for carrier sense access
+#define RF69_CSMA_SLOT        1 // ms, contention slot the channel has to stay clear for
+#define RF69_CSMA_CW_MIN      8 // slots, initial contention window, doubled every time the channel is found busy
+#define RF69_CSMA_CW_MAX     64
+#define RF69_CSMA_MAX_TIME 1000 // ms, default for how long send() waits for a clear channel before giving up
+#define RF69_TX_OK            0 // send() result codes
+#define RF69_TX_CHANNEL_BUSY  1 // channel not clear within the maximum access time, nothing was sent
+#define RF69_TX_DUTY_CYCLE    2 // frame would exceed the duty cycle budget set with setDutyCycle(), nothing was sent
 #define RF69_MODE_SLEEP       0 // XTAL OFF
 #define	RF69_MODE_STANDBY     1 // XTAL ON
 #define RF69_MODE_SYNTH	      2 // PLL ON
 #define RF69_MODE_RX          3 // RX MODE
 #define RF69_MODE_TX		      4 // TX MODE
+#define RF69_MODE_LISTEN      5 // listen mode, the chip alternates idle and RX on its own
 
 //available frequency bands
 #define RF69_315MHZ     31  // non trivial values to avoid misconfiguration
@@ -28,70 +50,541 @@
 #define RF69_868MHZ     86
 #define RF69_915MHZ     91
 
+//modem profiles for setModem(), bitrate and frequency deviation, the receiver bandwidth follows from them
+#define RF69_MODEM_DEFAULT  0 // 2.7kbps, FDEV 90kHz, RxBw 125kHz, what initialize() sets
+#define RF69_MODEM_4K8      1 // FDEV 5kHz
+#define RF69_MODEM_9K6      2 // FDEV 10kHz
+#define RF69_MODEM_19K2     3 // FDEV 20kHz
+#define RF69_MODEM_38K4     4 // FDEV 40kHz
+#define RF69_MODEM_55K5     5 // FDEV 50kHz
+#define RF69_MODEM_100K     6 // FDEV 100kHz
+#define RF69_MODEM_200K     7 // FDEV 100kHz
+#define RF69_MODEM_300K     8 // FDEV 100kHz
+#define RF69_MODEM_PROFILES 9
+#define RF69_FREQ_TOLERANCE 20000 // Hz, crystal offset between two nodes the receiver bandwidth leaves room for (~22ppm at 915MHz)
+#define RF69_AFC_TOLERANCE   5000 // Hz, offset left after the AFC has centred the receiver, with setAfc() the receiver bandwidth only covers this
+#define RF69_DRIFT_INTERVAL 60000 // ms between temperature readings for setDriftCompensation()
+#define RF69_PA_RAMP_US     40 // REG_PARAMP default, the RX restart delay has to outlast the sender's PA ramp-down
+#define RF69_RATE_HOLD     250 // ms a node stays on a rate it was switched to after the last frame at that rate, then goes back to its base profile
+#define RF69_RATE_SAMPLE    10 // 1 in this many sendWithRetry() frames tries a rate other than the best one
+#define RF69_RATE_TURNAROUND 2000 // us per exchange that doesn't shrink with the bitrate (mode changes, SPI, ACK turnaround)
+
 #define null                  0
 #define COURSE_TEMP_COEF    -90 // puts the temperature reading in the ballpark, user can fine tune the returned value
 #define RF69_BROADCAST_ADDR 255
 
+// control byte, 4th byte of every frame
+#define RF69_CTL_SENDACK   0x80
+#define RF69_CTL_REQACK    0x40
+#define RF69_CTL_EXT       0x20 // first payload byte is an extension header consumed by the library, see RF69_EXT_*
+#define RF69_CTL_LZ        0x10 // payload behind the extension headers is compressed, see setCompression()
+#define RF69_CTL_SEQ       0x0F // per-link sequence number 1..15 so retransmissions can be recognized, 0 = none (broadcast, older nodes)
+
+// extension headers at the start of the payload of RF69_CTL_EXT frames, each starts with this byte
+#define RF69_EXT_TYPE      0x0F
+#define RF69_EXT_MORE      0x10 // another extension header follows this one, else the payload does
+#define RF69_EXT_BULK      0x01 // sendBulk() data: [ext][transfer][index lo][index hi][data], REQACK asks for a block ACK
+#define RF69_EXT_BULKACK   0x02 // block ACK: [ext][transfer][next index lo][next index hi][bitmap of next+0..7]
+#define RF69_EXT_BULK_LAST 0x80 // last frame of a transfer
+#define RF69_EXT_HOP       0x03 // [ext][phase], how far into its dwell (1/256ths) the sender was, see setHopping()
+#define RF69_EXT_WAKE      0x04 // [ext][ms lo][ms hi], listenModeSendBurst() copy, the burst goes on that long
+#define RF69_EXT_RSSI      0x05 // [ext] asks for the RSSI in the ACK, the ACK carries it as [ext|RF69_EXT_REPORT][dBm], see enableAutoPower()
+#define RF69_EXT_REPORT    0x80
+#define RF69_EXT_RATE      0x06 // [ext][profile], switch to that modem profile once this frame is in, see setRateAdaptation()
+#define RF69_EXT_FRAG      0x07 // sendMessage() fragment: [ext][message id][index][chunk][data], the data goes at index * chunk
+#define RF69_EXT_FRAG_LAST 0x80 // last fragment of a message
+#define RF69_EXT_RESERVE      2 // payload bytes headers added to every frame by startFrame() may take
+#define RF69_EXT_MAX          9 // all headers startFrame() may add, the payload is cut to make room
+
+#define RF69_BULK_CHUNK      (MAX_DATA_LEN - 4 - RF69_EXT_RESERVE) // data bytes per sendBulk() frame, less with setFec() or setSecurity()
+#ifndef RF69_BULK_WINDOW
+#define RF69_BULK_WINDOW      8 // frames sent back to back before waiting for the block ACK, at most 8
+#endif
+#if RF69_BULK_WINDOW > 8 || RF69_BULK_WINDOW < 1
+#error RF69_BULK_WINDOW must be 1..8, the block ACK bitmap is one byte
+#endif
+#define RF69_BULK_IDLE     1000 // ms, an unfinished transfer is abandoned for another sender's after this long
+#define RF69_FRAG_MAX        64 // fragments per sendMessage() message (~3.5KB with FIFO sized frames), 1 bit each per reassembly slot
+#ifndef RF69_FRAG_SLOTS
+#define RF69_FRAG_SLOTS       2 // messages reassembled at the same time, each gets an equal share of setMessageBuffer()
+#endif
+#define RF69_FRAG_TIMEOUT  2000 // ms without a fragment before a half assembled message's slot may go to another message
+
+#ifndef RF69_HOP_MAX_CHANNELS
+#define RF69_HOP_MAX_CHANNELS 0 // longest channel table setHopping() takes, costs a byte per channel, 0 = no hopping
+#endif
+#define RF69_ATPC_HYSTERESIS  6 // dB, ATPC steps down 1dB while the reported RSSI is more than this above the target
+#define RF69_ATPC_STEP_UP     3 // dB, ATPC steps up this much for every missed ACK, up to full power when a frame is lost
+#define RF69_LISTEN_RX_US   1984 // default listen mode RX window, 31 * 64us
+#define RF69_LISTEN_IDLE_US 1000400 // default listen mode idle time, 244 * 4.1ms
+#define RF69_LISTEN_RSSI_TIMEOUT 40 // 16 bit periods after an RSSI wake-up without a frame before going idle again
+#define RF69_HOP_LOCK_CYCLES  4 // hop sequences without hearing or sending a frame before a receiver parks on the first hop channel again
+#ifndef RF69_FEC
+#define RF69_FEC              0 // 1 = setFec() available, costs an RF69_FRAME_DATA_LEN byte buffer for the coded frame
+#endif
+#ifndef RF69_COMPRESSION
+#define RF69_COMPRESSION      0 // 1 = setCompression() available and compressed frames readable, costs an RF69_FRAME_DATA_LEN byte buffer
+#endif
+#ifndef RF69_SECURITY
+#define RF69_SECURITY         0 // 1 = setSecurity() available, costs an RF69_FRAME_DATA_LEN byte buffer and the replay windows
+#endif
+#ifndef RF69_SECURE_PEERS
+#define RF69_SECURE_PEERS     8 // senders setSecurity() keeps a replay window for, the least recently heard one makes room, 13 bytes each
+#endif
+#define RF69_SECURITY_OVERHEAD 8 // frame counter and MIC setSecurity() adds to every frame
+#ifndef RF69_SEQ_SLOTS
+#define RF69_SEQ_SLOTS        8 // destinations the next sequence number is kept for, the least recently sent to one makes room (and numbers from 1 again), 2 bytes each
+#endif
+#ifndef RF69_DUPLICATE_FILTER
+#define RF69_DUPLICATE_FILTER 1 // 0 = keep retransmitted frames we already have, saves the senders below
+#endif
+#ifndef RF69_DUPLICATE_SLOTS
+#define RF69_DUPLICATE_SLOTS  8 // senders the duplicate filter remembers, the least recently heard one makes room, 6 bytes each
+#endif
+#define RF69_DUPLICATE_TIMEOUT 4000 // ms, a sequence number heard longer ago is forgotten: longer than any retry sequence, a node that reset and numbers from 1 again is not dropped
+#define REG_SHADOW_LAST    0x3D // REG_PACKETCONFIG2, last register mirrored in RAM
+#define RF69_REG_SNAPSHOT_SIZE 0x4F // registers 0x01 (REG_OPMODE) to 0x4F (REG_TEMP2) as captured by snapshotRegs()
+
+#ifndef RF69_RX_QUEUE_SIZE
+#define RF69_RX_QUEUE_SIZE    4 // frames buffered by the ISR until the sketch reads them, must be a power of 2
+#endif
+#if (RF69_RX_QUEUE_SIZE & (RF69_RX_QUEUE_SIZE - 1)) != 0
+#error RF69_RX_QUEUE_SIZE must be a power of 2
+#endif
+
+#define RF69_ACK_TIMEOUT     30 // ms, sendWithRetry() ACK timeout until a round trip has been measured
+#define RF69_ACK_TIMEOUT_MIN  5 // ms, bounds of the adaptive ACK timeout
+#define RF69_ACK_TIMEOUT_MAX 1000
+#define RF69_BACKOFF_SLOT    10 // ms, retry n is delayed by a random 0..(RF69_BACKOFF_SLOT << n)-1 ms
+#ifndef RF69_PEER_SLOTS
+#define RF69_PEER_SLOTS       0 // destinations with link state kept by sendWithRetry(), least recently used is recycled, ~45 bytes each
+#endif                        // 0 = none: fixed ACK timeout, full power, no AFC offsets or rate adaptation and getPeer() returns null
+
+// per destination link state and delivery statistics
+struct RFM69Peer {
+  byte nodeID;                // 0 = free slot
+  word srtt;                  // smoothed ACK round trip time, ms * 8
+  word rttvar;                // round trip time variation, ms * 4
+  unsigned long delivered;    // frames ACKed
+  unsigned long failed;       // frames given up on after all retries
+  unsigned long retries;      // retransmissions spent
+  unsigned long deliveryTime; // ms from first attempt to ACK, summed over delivered frames
+  byte txBackoff;             // ATPC: dB below full power used for this destination
+  int8_t ackRssi;             // ATPC: RSSI the destination reported in its last ACK, 0 = none yet
+  int16_t freqOffset;         // AFC: FSTEP units the node transmits above our channel, moving average over its ACKs
+  byte freqSamples;           // AFC: ACKs freqOffset was measured on, stops at 255
+  byte rate;                  // rate adaptation: modem profile the destination listens on until rateUntil, its base profile after
+  unsigned long rateUntil;
+  byte rateProb[RF69_MODEM_PROFILES]; // rate adaptation: delivery ratio per profile, moving average 0..255, 0 = untried
+  unsigned long lastUsed;
+};
+
+// setSecurity() replay window of one sender: the highest frame counter accepted from it and
+// which of the 31 before it came in too
+struct RFM69Replay {
+  byte nodeID;                // 0 = free slot
+  uint32_t counter;
+  uint32_t window;            // bit n set = counter - n accepted
+  unsigned long lastUsed;
+};
+
+// Last sequence number sent to a destination
+struct RFM69TxSeq {
+  byte nodeID;
+  byte seq;                   // 0 = free slot
+};
+
+// Last sequence number heard from a sender, for the duplicate filter
+struct RFM69RxSeq {
+  byte nodeID;
+  byte seq;                   // 0 = free slot
+  unsigned long heard;
+};
+
+// sendMessage() reassembly slot
+struct RFM69Reassembly {
+  byte from;                  // 0 = free slot
+  byte id;
+  byte chunk;                 // data bytes in every fragment but the last
+  byte last;                  // index of the last fragment, 0xFF until it's in
+  word length;                // message length, once the last fragment is in
+  bool done;
+  byte received[RF69_FRAG_MAX / 8]; // bitmap of the fragments in
+  unsigned long lastRx;
+};
+
+// link counters, see getStats()/dumpStats(), fixed width so dumps read the same on every MCU
+struct RFM69Stats {
+  uint32_t rxFrames;          // frames that passed CRC, FEC, MIC and the duplicate filter
+  uint32_t rxCrcErrors;
+  uint32_t rxAddressMismatch; // for another node yet past the radio's address filter (promiscuous mode off)
+  uint32_t rxBadLength;       // shorter than the header or longer than a queue slot
+  uint32_t rxOverflows;       // receive queue full, the sketch is not keeping up
+  uint32_t rxDuplicates;      // retransmissions of frames already received
+  uint32_t txFrames;
+  uint32_t txRetries;         // retransmissions by sendWithRetry() and sendBulk()
+  uint32_t txFailures;        // sendWithRetry()/sendBulk() given up after all retries
+  uint32_t channelBusy;       // channel found busy while contending for it
+  uint32_t channelFailures;   // sends abandoned after the maximum channel access time
+  uint32_t channelAccessTime; // ms waiting for a clear channel
+  uint32_t modeTime[6];       // ms in sleep, standby, synth, RX, TX (airtime) and listen mode, indexed by RF69_MODE_*
+  uint32_t dutyCycleRejects;  // frames refused by the duty cycle limiter
+  uint32_t rxWakeups;         // receive interrupts serviced, compare against promiscuous(true) for what address filtering saves
+  uint32_t rxFecCorrected;    // bit errors repaired by setFec(), frames it couldn't repair count as rxCrcErrors
+  uint32_t rxAuthFailures;    // setSecurity(): MIC didn't match, forged or from a node with another key
+  uint32_t rxReplays;         // setSecurity(): frame counter already seen or older than the replay window
+};
+
+// a received frame as stored in the receive queue
+struct RFM69Frame {
+  byte datalen;
+  byte senderID;
+  byte targetID;
+  byte ctl;     //raw control byte (ACK flags)
+  int rssi;
+  bool rssiRequested; //sender runs ATPC, sendACK() reports rssi back
+  unsigned long timestamp; //getTimestampRate() ticks, PayloadReady edge at the end of the frame
+  int16_t afc;  //FSTEP (~61Hz) units the frame came in above our channel, with setAfc()
+  byte data[RF69_FRAME_DATA_LEN];
+};
+
 class RFM69 {
   public:
-    static volatile byte DATA[MAX_DATA_LEN];          // recv/xmit buf, including hdr & crc bytes
-    static volatile byte DATALEN;
-    static volatile byte SENDERID;
-    static volatile byte TARGETID; //should match _address
-    static volatile byte PAYLOADLEN;
-    static volatile byte ACK_REQUESTED;
-    static volatile byte ACK_RECEIVED; /// Should be polled immediately after sending a packet with ACK request
-    static volatile int RSSI; //most accurate RSSI during reception (closest to the reception)
-    static volatile byte _mode; //should be protected?
+    // all state is per instance, so several radios (each with its own CS pin and interrupt) can share one MCU
+    volatile byte DATA[RF69_FRAME_DATA_LEN];          // recv/xmit buf, including hdr & crc bytes
+    volatile byte DATALEN;
+    volatile byte SENDERID;
+    volatile byte TARGETID; //should match _address
+    volatile byte PAYLOADLEN;
+    volatile byte ACK_REQUESTED;
+    volatile byte ACK_RECEIVED; /// Should be polled immediately after sending a packet with ACK request
+    volatile int RSSI; //most accurate RSSI during reception (closest to the reception)
+    volatile long FREQERROR; //Hz the last frame came in above our channel, with setAfc()
+    volatile unsigned long TIMESTAMP; //getTimestampRate() ticks, taken as the last CRC byte came in
+    volatile byte _mode; //should be protected?
     
-    RFM69(byte slaveSelectPin=SPI_CS, byte interruptPin=RF69_IRQ_PIN, bool isRFM69HW=false) {
+    RFM69(byte slaveSelectPin=SPI_CS, byte interruptPin=RF69_IRQ_PIN, bool isRFM69HW=false, byte interruptNum=RF69_IRQ_NUM) {
       _slaveSelectPin = slaveSelectPin;
       _interruptPin = interruptPin;
+      _interruptNum = interruptNum;
       _mode = RF69_MODE_STANDBY;
       _promiscuousMode = false;
       _powerLevel = 31;
+      _paBoost = true;
+      _atpcTarget = 0;
+      _reportRssi = 0;
+      _ackRssi = 0;
+      _modemProfile = RF69_MODEM_DEFAULT;
+      _rateBase = 0xFF;
+      _rateSwitch = 0xFF;
+      _rateTx = 0xFF;
+      _rateSamples = 0;
+      _afcOn = false;
+      _txRetuned = false;
+      _frf = 0;
+      _frfTrim = 0;
+      _driftLinear = _driftSquare = 0;
+      _driftRef = 25;
+      _driftUpdated = 0;
       _isRFM69HW = isRFM69HW;
+      _rxHead = _rxTail = _rxOpened = 0;
+      _dupAckSeq = 0;
+      _ackWaitSeq = 0;
+      _lastRxSeq = 0;
+      _bulkBuffer = null;
+      _bulkSize = 0;
+      _bulkFrom = 0;
+      _bulkDone = false;
+      _bulkTxId = 0;
+      _msgBuffer = null;
+      _msgSlotSize = 0;
+      memset(_msgSlots, 0, sizeof(_msgSlots));
+      _msgCurrent = 0xFF;
+      _msgTxId = 0;
+      _rnd = 1;
+      _csmaLimit = CSMA_LIMIT;
+      _csmaMaxTime = RF69_CSMA_MAX_TIME;
+      memset(&_stats, 0, sizeof(_stats));
+      _modeSince = 0;
+      _dutyPermille = 0;
+      _hopCount = 0;
+      _burstEnd = 0;
+      _burstHeard = 0;
+#if RF69_PEER_SLOTS
+      memset(_peers, 0, sizeof(_peers));
+#endif
+      memset(_txSeq, 0, sizeof(_txSeq));
+#if RF69_DUPLICATE_FILTER
+      memset(_rxSeq, 0, sizeof(_rxSeq));
+#endif
+      _txAckRequested = false;
+      _txLeft = 0;
+      _rxStreaming = false;
+      _largeFrames = false;
+      _fec = false;
+      _compress = false;
+      _secure = false;
+      _sendDoneCallback = null;
+      _receiveCallback = null;
+      _rxBuffer = null;
+      _rxBufferSize = 0;
+      _spiTransactions = 0;
+      memset(_shadowValid, 0, sizeof(_shadowValid));
     }
 
     bool initialize(byte freqBand, byte ID, byte networkID=1);
     void setAddress(byte addr);
     bool canSend();
-    void send(byte toAddress, const void* buffer, byte bufferSize, bool requestACK=false);
-    bool sendWithRetry(byte toAddress, const void* buffer, byte bufferSize, byte retries=2, byte retryWaitTime=30);
+    byte send(byte toAddress, const void* buffer, byte bufferSize, bool requestACK=false); //RF69_TX_OK or RF69_TX_CHANNEL_BUSY
+    bool startSend(byte toAddress, const void* buffer, byte bufferSize, bool requestACK=false); //non-blocking, false if the channel is busy or a frame is still on air
+    bool sendDone(); //true once the frame handed to startSend() has left the radio
+    void setSendDoneCallback(void (*callback)(void)); //runs in interrupt context when a frame has been sent
+    void setReceiveCallback(void (*callback)(const RFM69Frame& frame)); //receiveDone() hands frames over in place instead of copying them to DATA
+    void setReceiveBuffer(void* buffer, byte bufferSize); //receiveDone() copies payloads (not ACKs) here instead of DATA, null for DATA again; every frame overwrites it, check DATALEN
+    bool sendWithRetry(byte toAddress, const void* buffer, byte bufferSize, byte retries=2, byte retryWaitTime=0); //0 = adaptive timeout
+    word getAckTimeout(byte nodeID); //current adaptive ACK timeout in ms
+    RFM69Peer* getPeer(byte nodeID, bool create=false); //link statistics, null if nothing was sent to nodeID yet
     void receiveStart();
     bool receiveDone();
+    bool popFrame(RFM69Frame& frame); //take the oldest queued frame without going through DATA/DATALEN etc
+    byte framesPending();
+    word getRxOverflows(); //frames dropped because the receive queue was full
+    word getRxDuplicates(); //retransmissions dropped (and ACKed again) because the frame was already received
+    bool sendBulk(byte toAddress, const void* buffer, word size, byte retries=3); //windowed transfer, only lost frames are resent
+    void setBulkBuffer(void* buffer, word size); //accept sendBulk() transfers into buffer, null to refuse them
+    word bulkReceived(); //size of a completed transfer, once, 0 while none is complete
+    byte bulkSender();
+    bool sendMessage(byte toAddress, const void* buffer, word size, byte retries=2); //cut into fragments, each through sendWithRetry()
+    void setMessageBuffer(void* buffer, word size); //reassembly pool for sendMessage() messages, null to refuse them
+    word messageReceived(); //length of a complete message, 0 if none, the previous one's slot is freed
+    const byte* messageData(); //the message messageReceived() returned, in the pool
+    byte messageSender();
     bool ACKReceived(byte fromNodeID);
-    void sendACK(const void* buffer = "", uint8_t bufferSize=0);
+    byte sendACK(const void* buffer = "", uint8_t bufferSize=0);
+    void setCsma(int rssiLimit=CSMA_LIMIT, word maxAccessTime=RF69_CSMA_MAX_TIME); //channel busy above rssiLimit dBm
+    unsigned long getChannelBusy(); //times the channel was found busy while contending for it
+    unsigned long getChannelFailures(); //sends abandoned after maxAccessTime
+    unsigned long getChannelAccessTime(); //total ms spent waiting for a clear channel
+    bool setHopping(const uint32_t* frfTable, byte channels, word dwellMs); //frequency hopping over frfTable (kept by the caller), null to stop
+    byte getHopChannel(); //index into frfTable currently tuned
+    bool listenModeSetDurations(uint32_t& rxDuration, uint32_t& idleDuration); //us, rounded to what the chip can do, false if out of range
+    void listenModeGetDurations(uint32_t& rxDuration, uint32_t& idleDuration);
+    void listenModeSetCriteria(byte criteria); //RF_LISTEN1_CRITERIA_RSSI or RF_LISTEN1_CRITERIA_RSSIANDSYNC
+    void listenModeStart(); //receive through listen mode until the next send, sleep or listenModeEnd()
+    void listenModeEnd();
+    byte listenModeSendBurst(byte toAddress, const void* buffer, byte bufferSize); //repeat the frame for a whole listen period, RF69_TX_DUTY_CYCLE if the duty cycle credit can't cover it
+    word getBurstRemaining(); //ms until the burst that woke us ends, answer after that; 0 if its payload left no room to say
+    unsigned long getAirtime(byte payloadSize); //us on air for a frame with payloadSize data bytes at the current settings
+    unsigned long getSendTimestamp(); //when the last frame sent was completely on air
+    unsigned long getTimestampNow();
+    unsigned long getTimestampRate(); //timestamp ticks per second
+    void setDutyCycle(word permille, unsigned long periodMs=3600000, word maxWaitMs=0); //0 permille = no limit
+    long getDutyCycleBudget(); //us of airtime available right now
+    void getStats(RFM69Stats& stats); //consistent copy of all counters
+    void resetStats();
+    void dumpStats(); //'S', sizeof(RFM69Stats), then the raw little endian struct on Serial
     void setFrequency(uint32_t FRF);
+    uint32_t getFrequency(); //FRF of the channel set, without the corrections below
+    void setAfc(bool onOff=true); //AFC on every frame, frames to a node are aimed at the offset its ACKs came in with
+    void setDriftCompensation(int ppbPerC, int ppbPerC2=0, int8_t refTemp=25); //crystal ppb = ppbPerC*(t-refTemp) + ppbPerC2*(t-refTemp)^2, 0,0 = off
     void encrypt(const char* key);
     void setCS(byte newSPISlaveSelect);
     int readRSSI(bool forceTrigger=false);
     void promiscuous(bool onOff=true);
     void setHighPower(bool onOFF=true); //have to call it after initialize for RFM69HW
+    bool setModem(byte profile); //RF69_MODEM_*, same on all nodes that talk to each other
+    bool setModem(unsigned long bitrate, unsigned long fdev, unsigned long rxBw=0); //bps, Hz, Hz (0 = from bitrate and fdev), false if invalid
+    unsigned long getBitrate();
+    bool setRateAdaptation(bool onOff=true, byte maxProfile=RF69_MODEM_300K); //sendWithRetry() picks a profile per destination, from the setModem() one up
+    bool setLargeFrames(bool onOff=true, byte fifoInterruptNum=1); //frames up to RF69_LARGE_DATA_LEN, needs DIO1 on an external interrupt
+    bool setFec(bool onOff=true); //forward error correction, same on all nodes, halves the payload a frame can carry, false without RF69_FEC
+    bool setCompression(bool onOff=true); //send payloads compressed when that makes them shorter, receivers need RF69_COMPRESSION, false without it
+    bool setSecurity(const void* key, uint32_t frameCounter=0); //AES-CCM with replay protection, 16 byte key same on all nodes, null = off, false without RF69_SECURITY
+    uint32_t getFrameCounter(); //counter the next secured frame goes out with, keep it across resets
     void setPowerLevel(byte level); //reduce/increase transmit power level
+    void setPowerDBm(int8_t dBm); //output power in dBm, picks the PA stages, clamped to what the module can do
+    void enableAutoPower(int8_t targetRSSI=-80); //ATPC, 0 turns it off and restores the setPowerLevel() power
     void sleep();
     byte readTemperature(byte calFactor=0); //get CMOS temperature (8bit)
     void rcCalibration(); //calibrate the internal RC oscillator for use in wide temperature variations - see datasheet section [4.3.5. RC Timer Accuracy]
 
     // allow hacking registers by making these public
+    // configuration registers are mirrored in RAM: reads are served from the mirror and
+    // writes that would not change the register are skipped, readRegDirect() always goes to the chip
     byte readReg(byte addr);
+    byte readRegDirect(byte addr);
     void writeReg(byte addr, byte val);
+    void writeRegBurst(byte addr, const void* buffer, byte len); //consecutive registers in one SPI transaction
+    void readRegBurst(byte addr, void* buffer, byte len);
+    void snapshotRegs(byte* buffer); //whole register map (RF69_REG_SNAPSHOT_SIZE bytes, from 0x01) in one burst
+    unsigned long getSpiTransactions(); //sample before and after a send/receive to see its SPI cost
     void readAllRegs();
 
   protected:
     static void isr0();
+    static void isr1();
+    static void isr2();
+    void attachIsr(byte interruptNum, int mode);
     void virtual interruptHandler();
-    void sendFrame(byte toAddress, const void* buffer, byte size, bool requestACK=false, bool sendACK=false);
+    void sendFrame(byte toAddress, const void* buffer, byte size, bool requestACK=false, bool sendACK=false, byte seq=0);
+    void startFrame(byte toAddress, const void* buffer, byte size, bool requestACK, bool sendACK, byte seq);
+    byte sendSequenced(byte toAddress, const void* buffer, byte bufferSize, bool requestACK, byte seq);
+    byte accessChannel(bool contend=true);
+    byte waitDutyCycle(byte size, word maxWait);
+    byte waitAirtime(unsigned long airtime, word maxWait);
+    unsigned long frameAirtime(word dataLen);
+    void refillDutyCycle();
+    void openFrames();
+    bool acceptFrame(RFM69Frame* frame);
+    void receiveHeaders(RFM69Frame* frame);
+    void updateHop();
+    void resyncHop(byte phase, byte size, unsigned long heard);
+    bool receiving() { return _mode == RF69_MODE_RX || _mode == RF69_MODE_LISTEN; }
+    byte nextSeq(byte toAddress);
+#if RF69_DUPLICATE_FILTER
+    bool isDuplicate(byte nodeID, byte seq);
+    void rememberSeq(byte nodeID, byte seq);
+#endif
+    void sendPendingACK();
+    void updateRtt(RFM69Peer* peer, word rtt);
+    void updatePower(RFM69Peer* peer, int step);
+    void updateRate();
+    void switchRate(byte profile);
+    byte pickRate(RFM69Peer* peer, byte payloadSize);
+    unsigned long rateScore(byte profile, byte prob, byte payloadSize);
+    void tune(uint32_t FRF);
+    void updateDrift();
+    void learnOffset(const RFM69Frame& frame);
+    RFM69Frame* peekFrame();
+    void moveToFront(byte index);
+    bool receiveExt(RFM69Frame* frame);
+    void receiveBulk(RFM69Frame* frame);
+    byte bulkChunk();
+    void receiveFragment(RFM69Frame* frame);
+    bool sendReliable(byte toAddress, const void* buffer, byte bufferSize, byte retries, byte retryWaitTime, byte ext);
+    bool decodeFrame(RFM69Frame* frame);
+    bool expandFrame(RFM69Frame* frame);
+    bool openFrame(RFM69Frame* frame);
+    bool takeBulkAck(byte fromNodeID, byte transfer, word* next, byte* bitmap);
+    word random16();
 
-    static RFM69* selfPointer;
+    static RFM69* _irqOwner[RF69_MAX_IRQ]; //radio served by each external interrupt
     byte _slaveSelectPin;
     byte _interruptPin;
+    byte _interruptNum;
     byte _address;
     bool _promiscuousMode;
     byte _powerLevel;
     bool _isRFM69HW;
+    bool _paBoost; //RFM69HW +20dBm settings while in TX
+    int8_t _atpcTarget; //RSSI enableAutoPower() steers peers to, 0 = ATPC off
+    int8_t _reportRssi; //RSSI for the next sendACK() to report, 0 = not asked for
+    volatile int8_t _ackRssi; //RSSI reported in the last ACK received, 0 = none
+    volatile byte _ackRssiFrom;
+    byte _modemProfile; //RF69_MODEM_* programmed, 0xFF = custom setModem()
+    byte _rateBase; //profile every node listens on, 0xFF = rate adaptation off
+    byte _rateMax;
+    volatile byte _rateSwitch; //profile a received frame asked us to switch to, 0xFF = none
+    volatile unsigned long _rateHoldUntil; //millis() at which we go back to _rateBase
+    byte _rateTx; //profile the next frame asks its destination to switch to, 0xFF = none
+    byte _rateSamples;
+    bool _afcOn;
+    volatile bool _txRetuned; //the frame on air went out off the channel, the ISR tunes back
+    uint32_t _frf; //channel from setFrequency()
+    long _frfTrim; //FSTEP units the crystal drift compensation adds to every frequency
+    int _driftLinear;
+    int _driftSquare;
+    int8_t _driftRef;
+    unsigned long _driftUpdated; //millis() of the last temperature reading, 0 = none yet
+
+    RFM69Frame _rxQueue[RF69_RX_QUEUE_SIZE];
+    volatile byte _rxHead; //only advanced by the ISR
+    volatile byte _rxTail; //only advanced by receiveDone()/popFrame()
+    byte _rxOpened; //frames from _rxTail up to here went through acceptFrame()
+    volatile byte _dupAckTo; //retransmission to ACK again from the main loop
+    volatile byte _dupAckSeq;
+    byte _ackWaitSeq; //sequence number of the frame we expect an ACK for
+    byte _lastRxSeq; //sequence number of the last frame handed to the sketch, echoed in sendACK()
+#if RF69_PEER_SLOTS
+    RFM69Peer _peers[RF69_PEER_SLOTS];
+#endif
+    byte* _bulkBuffer; //sendBulk() reception state, one transfer at a time
+    word _bulkSize;
+    byte _bulkFrom;
+    byte _bulkId;
+    word _bulkNext; //frames before this index are all in
+    byte _bulkMap; //frames _bulkNext+0..7 received out of order
+    word _bulkEnd; //frame count once the last frame is in, 0 before
+    word _bulkLength;
+    bool _bulkDone;
+    unsigned long _bulkLastRx;
+    byte _bulkTxId;
+    byte* _msgBuffer; //sendMessage() reassembly pool
+    word _msgSlotSize;
+    RFM69Reassembly _msgSlots[RF69_FRAG_SLOTS];
+    byte _msgCurrent; //slot messageReceived() handed out, 0xFF = none
+    byte _msgTxId;
+    unsigned long _rnd;
+    int _csmaLimit;
+    word _csmaMaxTime;
+    RFM69Stats _stats; //updated from the ISR too, read through getStats()
+    unsigned long _modeSince; //millis() of the last mode change
+    word _dutyPermille; //duty cycle token bucket, in us of airtime
+    long _dutyBucket; //credit a full period earns
+    word _dutyMaxWait;
+    long _dutyTokens; //ACKs are never held back and may take it below 0
+    unsigned long _dutyUpdated;
+    byte _listenConfig[3]; //REG_LISTEN1..3
+    unsigned long _burstEnd; //millis() at which our listenModeSendBurst() stops, 0 = no burst
+    unsigned long _burstHeard; //millis() at which the burst we heard ends
+    const uint32_t* _hopTable;
+    byte _hopCount; //0 = hopping off
+    word _hopDwell;
+#if RF69_HOP_MAX_CHANNELS
+    byte _hopSeq[RF69_HOP_MAX_CHANNELS]; //hop sequence, permutation of the table indexes seeded by the network ID
+#endif
+    byte _hopPos; //position in _hopSeq currently tuned
+    volatile unsigned long _hopEpoch; //millis() at which position 0 of the sequence started
+    volatile unsigned long _hopLastSync; //last frame heard or sent, hopping follows _hopEpoch only while this is recent
+    RFM69TxSeq _txSeq[RF69_SEQ_SLOTS]; //most recently sent to first
+#if RF69_DUPLICATE_FILTER
+    RFM69RxSeq _rxSeq[RF69_DUPLICATE_SLOTS]; //last sequence number received from the most recently heard senders
+#endif
+    volatile bool _txAckRequested;
+    const byte* _txNext; //rest of a large frame, streamed into the FIFO by the ISR
+    volatile unsigned long _txTimestamp;
+    volatile byte _txLeft;
+    bool _rxStreaming; //ISR is part way through a frame
+    byte _rxLeft;
+    bool _largeFrames;
+    bool _fec;
+#if RF69_FEC
+    byte _fecBuf[RF69_FRAME_DATA_LEN]; //coded frame being sent, the ISR streams it when it's larger than the FIFO
+#endif
+    bool _compress;
+#if RF69_COMPRESSION
+    byte _lzBuf[RF69_FRAME_DATA_LEN]; //compressed payload being sent, or a received one being expanded
+#endif
+    bool _secure;
+#if RF69_SECURITY
+    byte _secKey[16];
+    uint32_t _txCounter;
+    byte _secBuf[RF69_FRAME_DATA_LEN]; //counter, encrypted ext headers and payload and MIC of the frame being sent
+    RFM69Replay _replay[RF69_SECURE_PEERS];
+#endif
+    byte _fifoInterruptNum;
+    void (*_sendDoneCallback)(void);
+    void (*_receiveCallback)(const RFM69Frame& frame);
+    byte* _rxBuffer; //setReceiveBuffer() destination, null = DATA
+    byte _rxBufferSize;
+    volatile unsigned long _spiTransactions;
+    byte _shadow[REG_SHADOW_LAST + 1]; //RAM copy of the configuration registers
+    byte _shadowValid[(REG_SHADOW_LAST + 8) / 8];
 
     void receiveBegin();
+    void armReceiver();
+    void clearFIFO();
+    void dropFrame(bool payloadReady);
     void setMode(byte mode);
     void setHighPowerRegs(bool onOff);
     void select();
@@ -0,0 +1,130 @@
+// **********************************************************************************
+// AES-CCM link security for RFM69 frames (see RFM69::setSecurity())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#include <RFM69ccm.h>
+
+static const byte AES_SBOX[256] = {
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static byte xtime(byte x) { return (x << 1) ^ (x & 0x80 ? 0x1B : 0); }
+
+// The state is kept column by column as in the block, byte i is row i & 3 of column i >> 2
+void aesEncrypt(byte* block, const byte* key)
+{
+  byte k[16];
+  byte s[16];
+  byte rcon = 1;
+  memcpy(k, key, 16);
+  for (byte i = 0; i < 16; i++)
+    block[i] ^= k[i];
+  for (byte round = 1; round <= 10; round++)
+  {
+    for (byte i = 0; i < 16; i++) //SubBytes and ShiftRows, row r moves r columns left
+      s[i] = AES_SBOX[block[(i + 4 * (i & 3)) & 15]];
+    if (round < 10) //MixColumns
+      for (byte c = 0; c < 16; c += 4)
+      {
+        byte a0 = s[c], a1 = s[c + 1], a2 = s[c + 2], a3 = s[c + 3];
+        byte all = a0 ^ a1 ^ a2 ^ a3;
+        s[c]     ^= all ^ xtime(a0 ^ a1);
+        s[c + 1] ^= all ^ xtime(a1 ^ a2);
+        s[c + 2] ^= all ^ xtime(a2 ^ a3);
+        s[c + 3] ^= all ^ xtime(a3 ^ a0);
+      }
+    k[0] ^= AES_SBOX[k[13]] ^ rcon; //next round key
+    k[1] ^= AES_SBOX[k[14]];
+    k[2] ^= AES_SBOX[k[15]];
+    k[3] ^= AES_SBOX[k[12]];
+    for (byte i = 4; i < 16; i++)
+      k[i] ^= k[i - 4];
+    rcon = xtime(rcon);
+    for (byte i = 0; i < 16; i++)
+      block[i] = s[i] ^ k[i];
+  }
+}
+
+// CBC-MAC over B0, the header with its length and the payload, each zero padded to whole blocks
+static void ccmMac(RFM69Cipher cipher, const byte* key, const byte* nonce, const byte* aad, byte aadLen, const byte* data, byte len, byte* x)
+{
+  x[0] = (aadLen ? 0x40 : 0) | ((RF69_CCM_MIC_LEN - 2) / 2) << 3 | (2 - 1);
+  memcpy(x + 1, nonce, RF69_CCM_NONCE_LEN);
+  x[14] = 0;
+  x[15] = len;
+  cipher(x, key);
+  if (aadLen)
+  {
+    x[1] ^= aadLen;
+    for (byte i = 0; i < aadLen; i++)
+      x[2 + i] ^= aad[i];
+    cipher(x, key);
+  }
+  while (len)
+  {
+    byte n = len < 16 ? len : 16;
+    for (byte i = 0; i < n; i++)
+      x[i] ^= data[i];
+    cipher(x, key);
+    data += n;
+    len -= n;
+  }
+}
+
+// XOR with the key stream from counter block i on: block 0 covers the MAC, 1 onwards the payload
+static void ccmCtr(RFM69Cipher cipher, const byte* key, const byte* nonce, byte* data, byte len, byte i)
+{
+  byte s[16];
+  while (len)
+  {
+    s[0] = 2 - 1;
+    memcpy(s + 1, nonce, RF69_CCM_NONCE_LEN);
+    s[14] = 0;
+    s[15] = i++;
+    cipher(s, key);
+    byte n = len < 16 ? len : 16;
+    for (byte j = 0; j < n; j++)
+      data[j] ^= s[j];
+    data += n;
+    len -= n;
+  }
+}
+
+void ccmSeal(RFM69Cipher cipher, const byte* key, const byte* nonce, const byte* aad, byte aadLen, byte* data, byte len, byte* mic)
+{
+  byte x[16];
+  ccmMac(cipher, key, nonce, aad, aadLen, data, len, x);
+  ccmCtr(cipher, key, nonce, x, RF69_CCM_MIC_LEN, 0);
+  memcpy(mic, x, RF69_CCM_MIC_LEN);
+  ccmCtr(cipher, key, nonce, data, len, 1);
+}
+
+bool ccmOpen(RFM69Cipher cipher, const byte* key, const byte* nonce, const byte* aad, byte aadLen, byte* data, byte len, const byte* mic)
+{
+  byte x[16];
+  ccmCtr(cipher, key, nonce, data, len, 1);
+  ccmMac(cipher, key, nonce, aad, aadLen, data, len, x);
+  ccmCtr(cipher, key, nonce, x, RF69_CCM_MIC_LEN, 0);
+  byte diff = 0; //every byte compared, how far a forged MIC matches must not show in the timing
+  for (byte i = 0; i < RF69_CCM_MIC_LEN; i++)
+    diff |= x[i] ^ mic[i];
+  return !diff;
+}
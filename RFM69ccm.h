@@ -0,0 +1,31 @@
+// **********************************************************************************
+// AES-CCM link security for RFM69 frames (see RFM69::setSecurity())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#ifndef RFM69ccm_h
+#define RFM69ccm_h
+#include <Arduino.h>
+
+// CCM as in RFC 3610 with a 2 byte length field: the payload is encrypted in counter mode and
+// a CBC-MAC over the header and the payload, cut to RF69_CCM_MIC_LEN bytes, rides behind it.
+// Only the AES forward direction is needed, one block at a time
+#define RF69_CCM_NONCE_LEN 13
+#define RF69_CCM_MIC_LEN    4 // bytes of the MAC sent, a forgery gets through once in 2^32 tries
+#define RF69_CCM_AAD_MAX   14 // authenticated header bytes, fits the first MAC block next to its length
+
+typedef void (*RFM69Cipher)(byte* block, const byte* key); // encrypts one 16 byte block in place with a 16 byte key
+
+#ifdef HAVE_AES_ENGINE
+#define RF69_AES aesEngineEncrypt // the MCU's AES peripheral, see the port's Arduino.h
+#else
+#define RF69_AES aesEncrypt
+#endif
+
+void aesEncrypt(byte* block, const byte* key); // AES-128 in software, round keys made on the fly
+void ccmSeal(RFM69Cipher cipher, const byte* key, const byte* nonce, const byte* aad, byte aadLen, byte* data, byte len, byte* mic); // encrypts data in place
+bool ccmOpen(RFM69Cipher cipher, const byte* key, const byte* nonce, const byte* aad, byte aadLen, byte* data, byte len, const byte* mic); // decrypts data in place, false if the MIC doesn't match
+
+#endif
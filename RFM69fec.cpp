@@ -0,0 +1,93 @@
+// **********************************************************************************
+// Forward error correction for RFM69 frames (see RFM69::setFec())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#include <RFM69fec.h>
+
+// Hamming(8,4) code byte: data nibble in bits 0-3, parity d0^d1^d3, d0^d2^d3, d1^d2^d3
+// in bits 4-6, parity over the other 7 bits in bit 7
+static const byte FEC_ENCODE[16] = {
+  0x00, 0xB1, 0xD2, 0x63, 0xE4, 0x55, 0x36, 0x87, 0x78, 0xC9, 0xAA, 0x1B, 0x9C, 0x2D, 0x4E, 0xFF
+};
+// syndrome of a code byte = FEC_SYNDROME_LO[low nibble] ^ FEC_SYNDROME_HI[high nibble],
+// bits 0-2 name the bit in error, bit 3 is set for an odd number of errors
+static const byte FEC_SYNDROME_LO[16] = {
+  0x00, 0x0B, 0x0D, 0x06, 0x0E, 0x05, 0x03, 0x08, 0x0F, 0x04, 0x02, 0x09, 0x01, 0x0A, 0x0C, 0x07
+};
+static const byte FEC_SYNDROME_HI[16] = {
+  0x00, 0x09, 0x0A, 0x03, 0x0C, 0x05, 0x06, 0x0F, 0x08, 0x01, 0x02, 0x0B, 0x04, 0x0D, 0x0E, 0x07
+};
+// bit to flip for each syndrome, 0xFF = two bit errors
+static const byte FEC_CORRECT[16] = {
+  0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x10, 0x20, 0x01, 0x40, 0x02, 0x04, 0x08
+};
+static const word FEC_CRC[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+word fecCrc(word crc, const void* data, byte len)
+{
+  const byte* p = (const byte*)data;
+  while (len--)
+  {
+    crc = (crc << 4) ^ FEC_CRC[(crc >> 12) ^ (*p >> 4)];
+    crc = (crc << 4) ^ FEC_CRC[(crc >> 12) ^ (*p++ & 0x0F)];
+  }
+  return crc;
+}
+
+byte* fecEncode(byte* code, const void* data, byte len)
+{
+  const byte* p = (const byte*)data;
+  while (len--)
+  {
+    *code++ = FEC_ENCODE[*p >> 4];
+    *code++ = FEC_ENCODE[*p++ & 0x0F];
+  }
+  return code;
+}
+
+int fecDecode(byte* data, const byte* code, byte len)
+{
+  int corrected = 0;
+  for (len >>= 1; len; len--)
+  {
+    byte b = 0;
+    for (byte i = 0; i < 2; i++)
+    {
+      byte c = *code++;
+      byte flip = FEC_CORRECT[FEC_SYNDROME_LO[c & 0x0F] ^ FEC_SYNDROME_HI[c >> 4]];
+      if (flip == 0xFF)
+        return -1;
+      if (flip)
+        corrected++;
+      b = (b << 4) | ((c ^ flip) & 0x0F);
+    }
+    *data++ = b;
+  }
+  return corrected;
+}
+
+// 8x8 bit matrix transpose (Hacker's Delight 7-3): bit j of byte i swaps with bit i of byte j
+void fecInterleave(byte* code, byte len)
+{
+  for (; len >= 8; len -= 8, code += 8)
+  {
+    uint32_t x = ((uint32_t)code[0] << 24) | ((uint32_t)code[1] << 16) | ((uint32_t)code[2] << 8) | code[3];
+    uint32_t y = ((uint32_t)code[4] << 24) | ((uint32_t)code[5] << 16) | ((uint32_t)code[6] << 8) | code[7];
+    uint32_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA; x ^= t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA; y ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x ^= t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y ^= t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+    code[0] = x >> 24; code[1] = x >> 16; code[2] = x >> 8; code[3] = x;
+    code[4] = y >> 24; code[5] = y >> 16; code[6] = y >> 8; code[7] = y;
+  }
+}
@@ -0,0 +1,23 @@
+// **********************************************************************************
+// Forward error correction for RFM69 frames (see RFM69::setFec())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#ifndef RFM69fec_h
+#define RFM69fec_h
+#include <Arduino.h>
+
+// Every data nibble goes out as an extended Hamming(8,4) code byte, which corrects one bit error
+// and detects two. Code bytes are bit-interleaved in groups of 8, so a burst of up to 8 bits on air
+// touches each code byte of the group once. A CRC-16 coded along with the data catches the rest
+#define RF69_FEC_CRC_LEN        2 // CRC-16 bytes behind the data, before coding
+#define RF69_FEC_CODED_LEN(n)   (2 * ((n) + RF69_FEC_CRC_LEN)) // bytes on air for n data bytes
+
+word fecCrc(word crc, const void* data, byte len); // CRC-16/CCITT (0x1021), start with 0xFFFF
+byte* fecEncode(byte* code, const void* data, byte len); // 2 * len code bytes, returns the end
+int fecDecode(byte* data, const byte* code, byte len); // len / 2 data bytes, may overlap code, bits corrected or -1 if uncorrectable
+void fecInterleave(byte* code, byte len); // transposes each whole group of 8 bytes, undoes itself
+
+#endif
@@ -0,0 +1,101 @@
+// **********************************************************************************
+// Payload compression for RFM69 frames (see RFM69::setCompression())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#include <RFM69lz.h>
+
+// What the window holds before the first byte of every frame: padding of packed structs,
+// the strings the example sketches send and the usual telemetry keys. Both ends need the same
+static const byte LZ_DICT[] =
+  "\0\0\0\0\0\0" "\xFF\xFF\xFF\xFF"
+  "FLASH_MEM_ID:0x"
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+  " uptime:" " rssi:-" " bat:" " hum:" " temp:";
+#define LZ_DICT_LEN (sizeof(LZ_DICT) - 1)
+
+// Greedy: at each position the longest match anywhere in the window wins, else the byte joins
+// a literal run. Gives up as soon as the output would not be shorter than the input
+byte lzCompress(byte* out, const void* data, byte len)
+{
+  const byte* in = (const byte*)data;
+  byte o = 0;   // output length
+  byte run = 0; // output index of the literal run token being filled
+  byte lit = 0; // bytes in that run, 0 = none open
+  byte p = 0;
+  while (p < len)
+  {
+    byte max = len - p > RF69_LZ_MAX_MATCH ? RF69_LZ_MAX_MATCH : len - p;
+    byte best = 0;
+    word bestDist = 0;
+    for (byte s = 0; s < p && best < max; s++) //earlier in the frame, may run into the bytes being matched
+    {
+      if (in[s] != in[p]) continue;
+      byte n = 1;
+      while (n < max && in[s + n] == in[p + n]) n++;
+      if (n > best) { best = n; bestDist = p - s; }
+    }
+    for (word d = p < 256 - LZ_DICT_LEN ? 0 : p + LZ_DICT_LEN - 256; d < LZ_DICT_LEN && best < max; d++)
+    {
+      if (LZ_DICT[d] != in[p]) continue;
+      byte n = 1;
+      while (n < max && d + n < LZ_DICT_LEN && LZ_DICT[d + n] == in[p + n]) n++;
+      if (n > best) { best = n; bestDist = p + LZ_DICT_LEN - d; }
+    }
+    if (best >= RF69_LZ_MIN_MATCH)
+    {
+      if (o + 2 >= len) return 0;
+      out[o++] = 0x80 | (best - RF69_LZ_MIN_MATCH);
+      out[o++] = bestDist - 1;
+      p += best;
+      lit = 0;
+    }
+    else
+    {
+      if (lit == 0 || lit == RF69_LZ_MAX_RUN)
+      {
+        if (o + 2 >= len) return 0;
+        run = o++;
+        lit = 0;
+      }
+      else if (o + 1 >= len) return 0;
+      out[o++] = in[p++];
+      out[run] = lit++;
+    }
+  }
+  return o;
+}
+
+int lzExpand(byte* out, byte size, const byte* in, byte len)
+{
+  byte o = 0;
+  while (len--)
+  {
+    byte token = *in++;
+    if (token < 0x80)
+    {
+      byte n = token + 1;
+      if (n > len || n > size - o) return -1;
+      memcpy(out + o, in, n);
+      in += n;
+      len -= n;
+      o += n;
+    }
+    else
+    {
+      if (!len--) return -1;
+      word dist = *in++ + 1;
+      byte n = (token & 0x7F) + RF69_LZ_MIN_MATCH;
+      if (n > size - o || dist > o + LZ_DICT_LEN) return -1;
+      int s = o - dist;
+      while (n--)
+      {
+        out[o++] = s < 0 ? LZ_DICT[LZ_DICT_LEN + s] : out[s];
+        s++;
+      }
+    }
+  }
+  return o;
+}
@@ -0,0 +1,24 @@
+// **********************************************************************************
+// Payload compression for RFM69 frames (see RFM69::setCompression())
+// **********************************************************************************
+// Creative Commons Attrib Share-Alike License
+// You are free to use/extend this library but please abide with the CCSA license:
+// http://creativecommons.org/licenses/by-sa/3.0/
+// **********************************************************************************
+#ifndef RFM69lz_h
+#define RFM69lz_h
+#include <Arduino.h>
+
+// LZ77 over a 256 byte window that starts in a small static dictionary of strings common in
+// telemetry, so even a short frame finds matches. The compressed stream is a series of tokens:
+//   0x00-0x7F  literal run, the next (token + 1) bytes are copied as they are
+//   0x80-0xFF  match of ((token & 0x7F) + 3) bytes, the next byte is the distance back - 1,
+//              counted from the end of the output so far into the dictionary in front of it
+#define RF69_LZ_MIN_MATCH   3 // shortest match worth a 2 byte token
+#define RF69_LZ_MAX_MATCH 130
+#define RF69_LZ_MAX_RUN   128
+
+byte lzCompress(byte* out, const void* data, byte len); // compressed length, 0 if not shorter than len, out takes len - 1 bytes
+int lzExpand(byte* out, byte size, const byte* in, byte len); // expanded length, -1 if malformed or more than size bytes
+
+#endif
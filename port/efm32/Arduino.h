@@ -60,6 +60,19 @@ uint32_t millis(void);
 void attachInterrupt(uint8_t, void (*)(void), int mode);
 void detachInterrupt(uint8_t);
 
+/* Hardware stamp of the rising edge on an external interrupt pin (capture.c) */
+#define HAVE_INPUT_CAPTURE
+void captureBegin(uint8_t interruptNum);
+uint32_t captureRead(uint8_t interruptNum);
+uint32_t captureNow(void);
+uint32_t captureTicksPerSecond(void);
+
+/* AES-128 block encryption on the AES peripheral and the core's cycle counter (crypto.c) */
+#define HAVE_AES_ENGINE
+#define HAVE_CYCLE_COUNTER
+void aesEngineEncrypt(uint8_t *block, const uint8_t *key);
+uint32_t cycleCount(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,106 @@
+#include <stdbool.h>
+
+#include "wiring_private.h"
+
+#include "em_cmu.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+/*
+ * Input capture of the external interrupt pins. PRS channel n carries the pin of
+ * interrupt n to CC channel n of TIMER1 (TIMER0 belongs to the USB stack), which
+ * latches the counter on the rising edge, so the stamp does not depend on how long
+ * the edge waits for its interrupt handler. The overflow interrupt extends the
+ * 16-bit counter to 32 bits.
+ */
+#define CAPTURE_TIMER		TIMER1
+#define CAPTURE_CLOCK		cmuClock_TIMER1
+#define CAPTURE_IRQ			TIMER1_IRQn
+#define CAPTURE_PRESCALE	timerPrescale16
+#define CAPTURE_DIVIDER		16
+#define CAPTURE_CHANNELS	3
+
+extern const uint8_t irq2Pin[];
+
+static volatile uint16_t overflows;
+static bool started;
+
+void TIMER1_IRQHandler(void)
+{
+	uint32_t flags = TIMER_IntGet(CAPTURE_TIMER);
+	TIMER_IntClear(CAPTURE_TIMER, flags);
+	if (flags & TIMER_IF_OF)
+		overflows++;
+}
+
+void captureBegin(uint8_t interruptNum)
+{
+	GpioPin_t gpio;
+	TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+	TIMER_InitCC_TypeDef ccInit = TIMER_INITCC_DEFAULT;
+
+	if (interruptNum >= CAPTURE_CHANNELS || !pinToGpio(irq2Pin[interruptNum], &gpio))
+		return;
+
+	CMU_ClockEnable(cmuClock_PRS, true);
+	CMU_ClockEnable(CAPTURE_CLOCK, true);
+
+	/* the pin reaches PRS through its external interrupt line, set up by attachInterrupt() */
+	PRS_SourceSignalSet(interruptNum,
+		gpio.Pin < 8 ? PRS_CH_CTRL_SOURCESEL_GPIOL : PRS_CH_CTRL_SOURCESEL_GPIOH,
+		PRS_CH_CTRL_SIGSEL_GPIOPIN0 + (gpio.Pin & 7),
+		prsEdgeOff);
+
+	ccInit.edge = timerEdgeRising;
+	ccInit.mode = timerCCModeCapture;
+	ccInit.prsSel = (TIMER_PRSSEL_TypeDef)(timerPRSSELCh0 + interruptNum);
+	ccInit.prsInput = true;
+	TIMER_InitCC(CAPTURE_TIMER, interruptNum, &ccInit);
+
+	if (!started)
+	{
+		started = true;
+		timerInit.prescale = CAPTURE_PRESCALE;
+		TIMER_TopSet(CAPTURE_TIMER, 0xFFFF);
+		TIMER_IntClear(CAPTURE_TIMER, TIMER_IF_OF);
+		TIMER_IntEnable(CAPTURE_TIMER, TIMER_IF_OF);
+		NVIC_EnableIRQ(CAPTURE_IRQ);
+		TIMER_Init(CAPTURE_TIMER, &timerInit);
+	}
+}
+
+uint32_t captureNow(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t high, low;
+
+	__disable_irq();
+	high = overflows;
+	low = TIMER_CounterGet(CAPTURE_TIMER);
+	if (TIMER_IntGet(CAPTURE_TIMER) & TIMER_IF_OF)
+	{
+		/* wrapped, but the overflow interrupt has not run yet */
+		low = TIMER_CounterGet(CAPTURE_TIMER);
+		high++;
+	}
+	__set_PRIMASK(primask);
+	return (high << 16) | low;
+}
+
+uint32_t captureRead(uint8_t interruptNum)
+{
+	uint32_t now;
+	uint16_t elapsed;
+
+	if (interruptNum >= CAPTURE_CHANNELS)
+		return 0;
+	/* the edge lies less than one counter period back, so only the low half is needed */
+	now = captureNow();
+	elapsed = (uint16_t)now - (uint16_t)TIMER_CaptureGet(CAPTURE_TIMER, interruptNum);
+	return now - elapsed;
+}
+
+uint32_t captureTicksPerSecond(void)
+{
+	return CMU_ClockFreqGet(CAPTURE_CLOCK) / CAPTURE_DIVIDER;
+}
@@ -0,0 +1,46 @@
+#include <stdbool.h>
+
+#include "wiring_private.h"
+
+#include "em_aes.h"
+#include "em_cmu.h"
+
+/*
+ * AES-128 on the AES peripheral, one block at a time as the CCM code in the library
+ * asks for it. em_aes reads the key and data as words, so both go through aligned
+ * copies. The peripheral holds one block at a time: the key and data registers are
+ * written and read with interrupts off, so another radio's ISR can't load its own block
+ * in between. The DWT cycle counter is there to time it against the software AES.
+ */
+static bool aesStarted;
+static bool cyclesStarted;
+
+void aesEngineEncrypt(uint8_t *block, const uint8_t *key)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t data[4], k[4];
+
+	if (!aesStarted)
+	{
+		aesStarted = true;
+		CMU_ClockEnable(cmuClock_AES, true);
+	}
+	memcpy(k, key, 16);
+	memcpy(data, block, 16);
+	__disable_irq();
+	AES_ECB128((uint8_t *)data, (const uint8_t *)data, 16, (const uint8_t *)k, true);
+	__set_PRIMASK(primask);
+	memcpy(block, data, 16);
+}
+
+uint32_t cycleCount(void)
+{
+	if (!cyclesStarted)
+	{
+		cyclesStarted = true;
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+	return DWT->CYCCNT;
+}
@@ -0,0 +1,198 @@
+// SX1231 model for the host tests, see sim.h
+#include "sim.h"
+#include <SPI.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define SIM_TICK_US    100 // interrupt timer period
+#define SIM_TX_TICKS     2 // PacketSent this many ticks after TX mode is entered
+
+SimRadio sim;
+HardwareSerial Serial;
+SPIClass SPI;
+uint32_t g_ms = 0;
+uint32_t g_msStep = 1;
+
+static sigset_t alarmSet;
+static volatile sig_atomic_t inIsr = 0;
+static volatile int txTicks = 0;
+static byte criticalFrame[SIM_FIFO_MAX];
+static int criticalLen = 0;
+static byte criticalInterrupt;
+static bool criticalArmed = false, criticalHit = false;
+static bool spiSelected = false;
+static int spiIndex;
+static byte spiAddr;
+static bool spiWrite;
+
+static byte opMode() { return (sim.regs[0x01] >> 2) & 7; }
+
+static void tick(int)
+{
+  if (!txTicks || --txTicks)
+    return;
+  inIsr = 1;
+  sim.regs[0x28] |= 0x08; //PacketSent
+  sim.txFifo = 0;
+  if (sim.isr[sim.txInterrupt]) sim.isr[sim.txInterrupt]();
+  if (sim.onSent) sim.onSent();
+  inIsr = 0;
+}
+
+struct SimStart {
+  SimStart()
+  {
+    sigemptyset(&alarmSet);
+    sigaddset(&alarmSet, SIGALRM);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = tick;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, 0);
+    struct itimerval t = { { 0, SIM_TICK_US }, { 0, SIM_TICK_US } };
+    setitimer(ITIMER_REAL, &t, 0);
+  }
+} simStart;
+
+SimRadio::SimRadio()
+{
+  memset(regs, 0, sizeof(regs));
+  regs[0x24] = 200; //RSSI -100dBm
+  regs[0x2D] = 3; //preamble, reset value, initialize() leaves it
+  rxLen = rxPos = txLen = txFifo = 0;
+  autoSent = true;
+  holdReady = false;
+  txInterrupt = 0;
+  memset(isr, 0, sizeof(isr));
+  onSent = 0;
+}
+
+void SimRadio::raise(byte interruptNum)
+{
+  bool nested = inIsr;
+  sigset_t old;
+  sigprocmask(SIG_BLOCK, &alarmSet, &old);
+  inIsr = 1;
+  if (isr[interruptNum]) isr[interruptNum]();
+  inIsr = nested;
+  sigprocmask(SIG_SETMASK, &old, 0);
+}
+
+void SimRadio::inject(const byte* frame, int len, byte interruptNum)
+{
+  rx[0] = len;
+  memcpy(rx + 1, frame, len);
+  rxLen = len + 1;
+  rxPos = 0;
+  regs[0x01] = (regs[0x01] & 0xE3) | 0x10; //the radio only receives in RX
+  regs[0x28] |= 0x04; //PayloadReady
+  raise(interruptNum);
+}
+
+void SimRadio::injectInCritical(const byte* frame, int len, byte interruptNum)
+{
+  memcpy(criticalFrame, frame, len);
+  criticalLen = len;
+  criticalInterrupt = interruptNum;
+  criticalArmed = true;
+  criticalHit = false;
+}
+
+void SimRadio::waitTx()
+{
+  while (txTicks);
+}
+
+void noInterrupts()
+{
+  sigprocmask(SIG_BLOCK, &alarmSet, 0);
+  if (criticalArmed && !inIsr)
+    criticalHit = true; //the frame arrives now, its ISR waits for interrupts()
+}
+
+void interrupts()
+{
+  if (inIsr)
+    return; //no nesting, the ISR returns with interrupts masked
+  if (criticalHit)
+  {
+    criticalArmed = criticalHit = false;
+    sim.inject(criticalFrame, criticalLen, criticalInterrupt);
+  }
+  sigprocmask(SIG_UNBLOCK, &alarmSet, 0);
+}
+
+void pinMode(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return HIGH; }
+void delay(uint32_t ms) { g_ms += ms; }
+uint32_t millis() { uint32_t t = g_ms; g_ms += g_msStep; return t; }
+uint32_t micros() { return g_ms * 1000; }
+void attachInterrupt(uint8_t n, void (*f)(void), int) { sim.isr[n] = f; }
+void detachInterrupt(uint8_t n) { sim.isr[n] = 0; }
+
+void digitalWrite(uint8_t, uint8_t value) //only chip select is driven
+{
+  spiSelected = value == LOW;
+  spiIndex = 0;
+}
+
+byte SPIClass::transfer(byte data)
+{
+  if (!spiSelected)
+    return 0;
+  if (spiIndex++ == 0)
+  {
+    spiAddr = data & 0x7F;
+    spiWrite = data & 0x80;
+    if (spiWrite && spiAddr == 0 && opMode() != 3)
+      sim.txLen = 0; //a new frame, the ISR tops up the FIFO in TX
+    return 0;
+  }
+  byte a = spiAddr;
+  if (a) spiAddr++; //burst access, the FIFO address doesn't move
+  if (a == 0x00)
+  {
+    if (spiWrite)
+    {
+      if (sim.txLen < SIM_FIFO_MAX) sim.tx[sim.txLen++] = data;
+      sim.txFifo++;
+      return 0;
+    }
+    if (sim.rxPos >= sim.rxLen)
+      return 0;
+    byte v = sim.rx[sim.rxPos++];
+    if (sim.rxPos >= sim.rxLen)
+      sim.regs[0x28] &= ~0x04;
+    return v;
+  }
+  if (spiWrite)
+  {
+    if (a == 0x28 && (data & 0x10)) //FifoOverrun clears the FIFO
+    {
+      sim.rxLen = sim.rxPos = 0;
+      sim.regs[0x28] &= ~0x04;
+      return 0;
+    }
+    if (a == 0x01)
+    {
+      sim.regs[0x28] &= ~0x08;
+      if (((data >> 2) & 7) == 3 && sim.autoSent)
+        txTicks = SIM_TX_TICKS;
+    }
+    sim.regs[a] = a == 0x3D ? (data & ~0x04) : data; //RxRestart reads back 0
+    return 0;
+  }
+  if (a == 0x27)
+    return sim.regs[a] | 0x80; //ModeReady
+  if (a == 0x28)
+  {
+    byte v = sim.regs[a] | 0x02; //CrcOk
+    int level = opMode() == 3 ? sim.txFifo : sim.rxLen - sim.rxPos;
+    if (level > (sim.regs[0x3C] & 0x7F)) v |= 0x20; else v &= ~0x20;
+    if (sim.holdReady) v &= ~0x04;
+    return v;
+  }
+  if (a == 0x23)
+    return 0x02; //RssiDone
+  return sim.regs[a];
+}
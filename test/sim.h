@@ -0,0 +1,37 @@
+// Host model of an SX1231 behind a mocked SPI bus, enough of it to run the driver:
+// registers, the FIFO in both directions, the IRQ flags the driver polls and the DIO
+// interrupts. Interrupts are a periodic SIGALRM on the main thread, so an ISR really
+// preempts the sketch wherever noInterrupts() doesn't hold it off, as on an MCU
+#ifndef sim_h
+#define sim_h
+#include <Arduino.h>
+#include <vector>
+
+#define SIM_FIFO_MAX 300
+
+struct SimRadio {
+  byte regs[0x80];
+  byte rx[SIM_FIFO_MAX];     // frame waiting in the FIFO for the driver, length byte first
+  int rxLen, rxPos;
+  byte tx[SIM_FIFO_MAX];     // last frame the driver wrote to the FIFO, length byte first
+  int txLen;
+  int txFifo;                // bytes in the FIFO while transmitting, for FifoLevel
+  bool autoSent;             // PacketSent follows TX mode by itself, else the test raises it
+  bool holdReady;            // keep PayloadReady low, the frame is still coming in
+  byte txInterrupt;          // interrupt PacketSent is raised on
+  void (*isr[3])(void);
+  void (*onSent)(void);      // after the PacketSent ISR, in interrupt context: must not allocate
+
+  SimRadio();
+  void inject(const byte* frame, int len, byte interruptNum = 0); // frame without the length byte, raises PayloadReady now
+  void inject(const std::vector<byte>& frame, byte interruptNum = 0) { inject(&frame[0], frame.size(), interruptNum); }
+  void injectInCritical(const byte* frame, int len, byte interruptNum = 0); // held off until the next noInterrupts() section ends
+  void raise(byte interruptNum); // run an ISR as if its pin had just risen
+  std::vector<byte> sent() const { return std::vector<byte>(tx + 1, tx + txLen); } // last frame without the length byte
+  void waitTx(); // until the frame on air has been sent
+};
+extern SimRadio sim;
+extern uint32_t g_ms;     // millis(), advances g_msStep on every call
+extern uint32_t g_msStep;
+
+#endif
@@ -0,0 +1,58 @@
+// Host stand-in for the Arduino core, just what the library uses. Interrupt masking
+// and the ISR timing are modelled in sim.cpp
+#ifndef Arduino_h
+#define Arduino_h
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+enum { LOW = 0, HIGH = 1 };
+enum { INPUT = 0, OUTPUT = 1, INPUT_PULLUP = 2 };
+enum { LSBFIRST = 0, MSBFIRST = 1 };
+enum { CHANGE = 1, FALLING = 2, RISING = 3 };
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define F_CPU 16000000UL
+static const uint8_t SS = 10;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void delay(uint32_t ms);
+uint32_t millis(void);
+uint32_t micros(void);
+void attachInterrupt(uint8_t interruptNum, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts(void);
+void interrupts(void);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+  virtual size_t write(const uint8_t* buf, size_t n) { for (size_t i = 0; i < n; i++) write(buf[i]); return n; }
+  size_t print(const char* s) { return printf("%s", s); }
+  size_t print(char c) { return printf("%c", c); }
+  size_t print(long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", v); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t println() { return printf("\n"); }
+  template<class T> size_t println(T v) { print(v); return println(); }
+  template<class T> size_t println(T v, int base) { print(v, base); return println(); }
+};
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+};
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+#include <Arduino.h>
+
+#define SPI_CLOCK_DIV2 4
+#define SPI_MODE0 0
+
+class SPIClass {
+public:
+  byte transfer(byte data); // sim.cpp: the SX1231 register and FIFO model
+  void begin() {}
+  void end() {}
+  void setBitOrder(uint8_t) {}
+  void setDataMode(uint8_t) {}
+  void setClockDivider(uint8_t) {}
+};
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,34 @@
+// Adaptive ACK timeout: RF69_ACK_TIMEOUT until a round trip has been measured, then
+// srtt + 4 * rttvar per destination, Karn's rule for retransmissions, and the least recently
+// used peer slot recycled
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+struct Radio : RFM69 {
+  using RFM69::updateRtt;
+};
+
+int main() {
+  Radio r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  assert(r.getAckTimeout(5) == RF69_ACK_TIMEOUT);
+  assert(!r.sendWithRetry(5, "x", 1, 2)); //nobody answers
+  RFM69Peer* p = r.getPeer(5);
+  assert(p && p->failed == 1 && p->retries == 2 && p->delivered == 0);
+  assert(r.getAckTimeout(5) == RF69_ACK_TIMEOUT); //no ACK, no sample
+
+  for (int i = 0; i < 20; i++)
+    r.updateRtt(p, 60);
+  word steady = r.getAckTimeout(5);
+  r.updateRtt(p, 120);
+  word spike = r.getAckTimeout(5);
+  printf("timeout after a steady 60ms: %u, after one 120ms: %u\n", steady, spike);
+  assert(steady >= 60 && steady <= 65 && spike > 120);
+
+  for (int n = 10; n < 10 + RF69_PEER_SLOTS; n++)
+    r.getPeer(n, true);
+  assert(!r.getPeer(5) && r.getAckTimeout(5) == RF69_ACK_TIMEOUT);
+  puts("ok");
+  return 0;
+}
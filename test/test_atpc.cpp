@@ -0,0 +1,66 @@
+// Automatic transmit power control against a destination behind a fixed path loss: frames ask
+// for the RSSI, the ACK reports it, and the sender settles at the lowest power that keeps the
+// report at the target, steps up after a loss increase and goes back to full power on a lost frame
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+static int loss = 70; //dB
+static bool mute = false;
+
+//node 5 answers every frame that wants an ACK, in interrupt context right after PacketSent
+static void onSent() {
+  byte ctl = sim.tx[3];
+  if (!(ctl & RF69_CTL_REQACK))
+    return;
+  assert((ctl & RF69_CTL_EXT) && sim.tx[4] == RF69_EXT_RSSI);
+  if (mute)
+    return;
+  int dBm = (sim.regs[0x11] & 0x1F) - 18; //PA0
+  byte ack[5] = { 1, 5, (byte)(RF69_CTL_SENDACK | RF69_CTL_EXT | (ctl & RF69_CTL_SEQ)), RF69_EXT_RSSI | RF69_EXT_REPORT, (byte)(int8_t)(dBm - loss) };
+  sim.inject(ack, 5);
+}
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  r.enableAutoPower(-80);
+  sim.onSent = onSent;
+  for (int i = 0; i < 40; i++)
+    assert(r.sendWithRetry(5, "hi", 2));
+  RFM69Peer* p = r.getPeer(5);
+  printf("%ddB path loss: %ddB below full power, reported %ddBm\n", loss, p->txBackoff, p->ackRssi);
+  assert(p->ackRssi >= -80 && p->ackRssi <= -80 + RF69_ATPC_HYSTERESIS + 1);
+
+  loss += 8;
+  assert(r.sendWithRetry(5, "hi", 2)); //reports the shortfall
+  assert(r.sendWithRetry(5, "hi", 2));
+  printf("%ddB path loss: %ddB below full power, reported %ddBm\n", loss, p->txBackoff, p->ackRssi);
+  assert(p->ackRssi >= -80);
+
+  mute = true;
+  assert(!r.sendWithRetry(5, "hi", 2, 1));
+  assert(p->txBackoff == 0);
+  mute = false;
+  sim.onSent = 0;
+  r.send(RF69_BROADCAST_ADDR, "b", 1);
+  sim.waitTx();
+  assert((sim.regs[0x11] & 0x1F) == 31);
+  r.enableAutoPower(0);
+  r.send(5, "hi", 2, true);
+  sim.waitTx();
+  assert(!(sim.tx[3] & RF69_CTL_EXT) && (sim.regs[0x11] & 0x1F) == 31);
+
+  //receiver side: a request is answered with the RSSI the frame came in at
+  byte f[5] = { 1, 9, RF69_CTL_REQACK | RF69_CTL_EXT | 3, RF69_EXT_RSSI, 'x' };
+  sim.inject(f, 5);
+  assert(r.receiveDone() && r.DATALEN == 1 && r.DATA[0] == 'x' && r.ACK_REQUESTED);
+  r.sendACK();
+  sim.waitTx();
+  assert(sim.tx[4] == (RF69_EXT_RSSI | RF69_EXT_REPORT) && (int8_t)sim.tx[5] == r.RSSI);
+  r.sendACK();
+  sim.waitTx();
+  assert(!(sim.tx[3] & RF69_CTL_EXT));
+  puts("ok");
+  return 0;
+}
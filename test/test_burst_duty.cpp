@@ -0,0 +1,30 @@
+// listenModeSendBurst() under setDutyCycle(): the burst lasts a whole listen period, it only
+// starts when the duty cycle credit covers all of it, not just one copy of the frame
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+static volatile int copies;
+static void onSent() { copies++; }
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  sim.onSent = onSent;
+  uint32_t rx = 1984, idle = 100000; //~100ms burst
+  r.listenModeSetDurations(rx, idle);
+
+  r.setDutyCycle(1, 60000, 0); //60ms of credit, plenty for one copy
+  assert(r.listenModeSendBurst(2, "wake", 4) == RF69_TX_DUTY_CYCLE);
+  assert(copies == 0);
+
+  r.setDutyCycle(10, 60000, 0); //600ms
+  long before = r.getDutyCycleBudget();
+  assert(r.listenModeSendBurst(2, "wake", 4) == RF69_TX_OK);
+  sim.waitTx();
+  assert(copies > 1);
+  assert(before - r.getDutyCycleBudget() >= (long)(copies - 1) * (long)r.getAirtime(4));
+
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,70 @@
+// Duplicate filter: a retransmission (same sequence number from the same sender) is dropped,
+// but only within RF69_DUPLICATE_TIMEOUT, a node that reset and numbers from 1 again gets through.
+// The least recently heard sender makes room when the table is full. Sending, each destination
+// gets its own numbering and the least recently sent to one is forgotten
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+static void inject(byte sender, byte seq, char payload) {
+  byte f[4] = { 1, sender, seq, (byte)payload };
+  sim.inject(f, 4);
+}
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  r.receiveDone();
+
+  inject(5, 1, 'a');
+  inject(5, 1, 'a');
+  assert(r.receiveDone() && r.DATA[0] == 'a' && !r.receiveDone());
+  assert(r.getRxDuplicates() == 1);
+  inject(5, 2, 'b');
+  assert(r.receiveDone() && r.DATA[0] == 'b');
+
+  //the sender reset and starts over, long after its last frame
+  inject(5, 1, 'c');
+  assert(r.receiveDone() && r.DATA[0] == 'c');
+  g_ms += RF69_DUPLICATE_TIMEOUT;
+  inject(5, 1, 'd');
+  assert(r.receiveDone() && r.DATA[0] == 'd');
+  assert(r.getRxDuplicates() == 1);
+
+  //a full table forgets the oldest sender only
+  for (int i = 0; i < RF69_DUPLICATE_SLOTS; i++)
+  {
+    inject(10 + i, 3, 'e');
+    assert(r.receiveDone());
+  }
+  inject(5, 1, 'f'); //evicted
+  assert(r.receiveDone() && r.DATA[0] == 'f');
+  inject(11, 3, 'g'); //kept
+  assert(!r.receiveDone() && r.getRxDuplicates() == 2);
+
+  //sequence numbers sent, per destination
+  r.send(2, "x", 1);
+  sim.waitTx();
+  assert((sim.tx[3] & RF69_CTL_SEQ) == 1);
+  r.send(2, "x", 1);
+  sim.waitTx();
+  assert((sim.tx[3] & RF69_CTL_SEQ) == 2);
+  for (int i = 0; i < RF69_SEQ_SLOTS; i++)
+  {
+    r.send(20 + i, "x", 1);
+    sim.waitTx();
+    assert((sim.tx[3] & RF69_CTL_SEQ) == 1);
+  }
+  r.send(20 + RF69_SEQ_SLOTS - 1, "x", 1); //kept
+  sim.waitTx();
+  assert((sim.tx[3] & RF69_CTL_SEQ) == 2);
+  r.send(2, "x", 1); //pushed out
+  sim.waitTx();
+  assert((sim.tx[3] & RF69_CTL_SEQ) == 1);
+  r.send(RF69_BROADCAST_ADDR, "x", 1);
+  sim.waitTx();
+  assert((sim.tx[3] & RF69_CTL_SEQ) == 0);
+
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,43 @@
+// The duty cycle credit is charged for the frame as it went on air: library extension headers,
+// the security counter and MIC and the FEC coding included. A duty cycle whose credit for the
+// period doesn't fit a long is capped, not wrapped negative
+#include "sim.h"
+#include <RFM69.h>
+#include <RFM69fec.h>
+#include <assert.h>
+
+struct Radio : RFM69 {
+  using RFM69::frameAirtime;
+};
+
+//credit spent on one frame, give or take the 1us per ms that accrues meanwhile
+static long charge(Radio& r, bool requestACK) {
+  long before = r.getDutyCycleBudget();
+  r.send(2, "0123456789", 10, requestACK);
+  sim.waitTx();
+  return before - r.getDutyCycleBudget();
+}
+
+static bool near(long a, long b) { return a - b < 100 && b - a < 100; }
+
+int main() {
+  Radio r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  r.setDutyCycle(1, 3600000UL, 0);
+  const byte key[16] = { 0 };
+
+  assert(near(charge(r, false), r.getAirtime(10)));
+  r.enableAutoPower(-80); //an RSSI request header on frames that want an ACK
+  assert(r.setSecurity(key) && r.setFec(true));
+  long spent = charge(r, true);
+  assert(sim.tx[0] - 3 > RF69_FEC_CODED_LEN(10 + RF69_SECURITY_OVERHEAD)); //the header went out coded too
+  assert(near(spent, r.frameAirtime(sim.tx[0] - 3)) && spent > (long)r.getAirtime(10) + 1000);
+
+  r.setDutyCycle(1000, 3600000UL, 0);
+  assert(r.getDutyCycleBudget() == 0x7FFFFFFF);
+  assert(r.send(2, "x", 1) == RF69_TX_OK);
+  g_ms += 1000;
+  assert(r.getDutyCycleBudget() == 0x7FFFFFFF); //refilled back to the cap
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,98 @@
+// FEC codec (RFM69fec.h): any single bit error and any burst of up to 8 bits within the whole
+// interleaving groups is repaired, and the goodput against bit error rate the FecBenchmark example prints on a board:
+// FEC gives up half the payload per frame, so it only pays off once plain frames start getting lost
+#include "sim.h"
+#include <RFM69.h>
+#include <RFM69fec.h>
+#include <assert.h>
+#include <string.h>
+
+#define PAYLOAD (MAX_DATA_LEN / 2 - RF69_FEC_CRC_LEN) //the most a FIFO sized frame carries with FEC
+#define CODED   RF69_FEC_CODED_LEN(PAYLOAD)
+#define HEADER  4   //length, target, sender, control byte: never coded
+#define FRAMES  2000
+
+static byte data[PAYLOAD], code[CODED], decoded[CODED / 2];
+static uint32_t rnd = 0x2545F491;
+
+static uint32_t random32() {
+  rnd ^= rnd << 13;
+  rnd ^= rnd >> 17;
+  rnd ^= rnd << 5;
+  return rnd;
+}
+
+//flips each of bits bits with probability threshold / 2^32, returns how many were flipped
+static int addErrors(byte* buf, int bits, uint32_t threshold) {
+  int flipped = 0;
+  for (int i = 0; i < bits; i++)
+    if (random32() < threshold)
+    {
+      if (buf) buf[i >> 3] ^= 1 << (i & 7);
+      flipped++;
+    }
+  return flipped;
+}
+
+static void encodeFrame() {
+  word crc = fecCrc(0xFFFF, data, PAYLOAD);
+  byte trailer[RF69_FEC_CRC_LEN] = { (byte)(crc >> 8), (byte)crc };
+  fecEncode(fecEncode(code, data, PAYLOAD), trailer, RF69_FEC_CRC_LEN);
+  fecInterleave(code, CODED);
+}
+
+static bool decodeFrame() {
+  fecInterleave(code, CODED);
+  if (fecDecode(decoded, code, CODED) < 0)
+    return false;
+  word crc = fecCrc(0xFFFF, decoded, PAYLOAD);
+  return decoded[PAYLOAD] == (byte)(crc >> 8) && decoded[PAYLOAD + 1] == (byte)crc
+      && !memcmp(decoded, data, PAYLOAD);
+}
+
+int main() {
+  for (int i = 0; i < PAYLOAD; i++)
+    data[i] = random32();
+
+  encodeFrame();
+  assert(decodeFrame());
+  for (int bit = 0; bit < CODED * 8; bit++) //one error anywhere
+  {
+    encodeFrame();
+    code[bit >> 3] ^= 1 << (bit & 7);
+    assert(decodeFrame());
+  }
+  for (int start = 0; start + 8 <= CODED / 8 * 64; start++) //a burst of 8 on air, in the interleaved groups
+  {
+    encodeFrame();
+    for (int bit = start; bit < start + 8; bit++)
+      code[bit >> 3] ^= 1 << (bit & 7);
+    assert(decodeFrame());
+  }
+
+  //plain frames carry the payload and the radio's 2 byte CRC, any bit error loses the frame
+  const double ber[] = { 0.0001, 0.0003, 0.001, 0.003, 0.01, 0.02 };
+  double plainGoodput[6], fecGoodput[6];
+  printf("BER      plain%%  fec%%    plain goodput  fec goodput\n");
+  for (int b = 0; b < 6; b++)
+  {
+    uint32_t threshold = ber[b] * 4294967296.0;
+    int plainOk = 0, fecOk = 0;
+    for (int f = 0; f < FRAMES; f++)
+    {
+      if (!addErrors(0, (HEADER + PAYLOAD + 2) * 8, threshold))
+        plainOk++;
+      encodeFrame();
+      if (!addErrors(0, HEADER * 8, threshold) && (addErrors(code, CODED * 8, threshold), decodeFrame()))
+        fecOk++;
+    }
+    plainGoodput[b] = (double)plainOk * PAYLOAD / FRAMES / (HEADER + PAYLOAD + 2);
+    fecGoodput[b] = (double)fecOk * PAYLOAD / FRAMES / (HEADER + CODED);
+    printf("%.4f   %5.1f   %5.1f   %.3f          %.3f\n", ber[b], 100.0 * plainOk / FRAMES,
+           100.0 * fecOk / FRAMES, plainGoodput[b], fecGoodput[b]);
+  }
+  assert(plainGoodput[0] > fecGoodput[0]); //clean channel: the halved payload costs
+  assert(fecGoodput[4] > 2 * plainGoodput[4] && fecGoodput[5] > plainGoodput[5]);
+  puts("ok");
+  return 0;
+}
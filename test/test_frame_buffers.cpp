@@ -0,0 +1,34 @@
+// Built with RF69_LARGE_FRAMES 0: setLargeFrames() still lets a sender stream large frames, but
+// FEC, compression and security build the frame in FIFO sized buffers, so with them on a frame
+// never grows past RF69_FRAME_DATA_LEN
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+#include <stdlib.h>
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  assert(RF69_FRAME_DATA_LEN == MAX_DATA_LEN);
+  assert(r.setLargeFrames(true, 1));
+  byte big[RF69_LARGE_DATA_LEN];
+  for (int i = 0; i < (int)sizeof(big); i++)
+    big[i] = rand();
+  const byte key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+  r.send(2, big, sizeof(big)); //no buffer involved, goes out whole
+  sim.waitTx();
+  assert(sim.tx[0] == sizeof(big) + 3);
+
+  for (int mode = 1; mode < 8; mode++)
+  {
+    assert(r.setFec(mode & 1));
+    r.setCompression(mode & 2);
+    assert(r.setSecurity(mode & 4 ? key : 0));
+    r.send(2, big, sizeof(big));
+    sim.waitTx();
+    assert(sim.tx[0] <= RF69_FRAME_DATA_LEN + 3);
+  }
+  puts("ok");
+  return 0;
+}
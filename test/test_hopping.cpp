@@ -0,0 +1,85 @@
+// Frequency hopping: two nodes of a network step through the same channel sequence, a receiver
+// that heard one frame follows the sender's hop clock (lockstep), and a full size payload goes
+// out whole, without the hop header, rather than cut to make room for it
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static RFM69 a(SPI_CS, RF69_IRQ_PIN, false, 0), b(SPI_CS, RF69_IRQ_PIN, false, 1);
+
+//a frame a just sent reaches b only if both are tuned to the same channel
+static bool deliver() {
+  if (b.getHopChannel() != a.getHopChannel())
+    return false;
+  std::vector<byte> f = sim.sent();
+  g_ms += a.getAirtime(f.size() - 3) / 1000;
+  sim.inject(f, 1);
+  return b.receiveDone();
+}
+
+int main() {
+  a.initialize(RF69_915MHZ, 1, 100);
+  b.initialize(RF69_915MHZ, 2, 100);
+  uint32_t table[20];
+  for (int i = 0; i < 20; i++)
+    table[i] = 0xE4C000 + i * 0x800;
+  assert(a.setHopping(table, 20, 100) && b.setHopping(table, 20, 100));
+  srand(1);
+  g_ms += 12345;
+
+  int heard = 0, checks = 0, mismatches = 0;
+  bool synced = false;
+  for (int k = 0; k < 3000; k++)
+  {
+    g_ms += rand() % 37;
+    if (k % 10 == 0)
+    {
+      b.receiveDone();
+      a.send(2, "hello", 5);
+      sim.waitTx();
+      g_msStep = 0;
+      b.receiveDone();
+      g_msStep = 1;
+      if (deliver())
+      {
+        heard++;
+        assert(b.DATALEN == 5 && !memcmp((const void*)b.DATA, "hello", 5));
+        synced = true;
+      }
+    }
+    g_msStep = 0;
+    b.receiveDone();
+    a.receiveDone();
+    g_msStep = 1;
+    if (synced)
+    {
+      checks++;
+      if (a.getHopChannel() != b.getHopChannel())
+        mismatches++;
+    }
+  }
+  printf("heard %d, channel mismatches %d of %d polls\n", heard, mismatches, checks);
+  //millis() moves on 1ms per call, so the sender's clock runs a few ms past the phase it stamped
+  //while send() works, that much of every 100ms dwell the two disagree near the boundary
+  assert(heard > 1 && mismatches * 10 < checks);
+
+  //a FIFO sized payload leaves no room for the hop header
+  byte full[MAX_DATA_LEN];
+  for (int i = 0; i < (int)sizeof(full); i++)
+    full[i] = i;
+  for (int tries = 0; tries < 100; tries++)
+  {
+    a.send(2, full, sizeof(full));
+    sim.waitTx();
+    assert(sim.sent().size() == 3 + sizeof(full));
+    if (deliver())
+      break;
+    g_ms += 37;
+  }
+  assert(b.DATALEN == sizeof(full) && !memcmp((const void*)b.DATA, full, sizeof(full)));
+
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,37 @@
+// setModem(): RF69_MODEM_DEFAULT reproduces what initialize() programs, every profile passes the
+// SX1231 constraints it is checked against, bad custom settings are refused untouched
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  byte before[5] = { sim.regs[0x03], sim.regs[0x04], sim.regs[0x19], sim.regs[0x1A], sim.regs[0x3D] };
+  unsigned long base = r.getAirtime(20);
+  assert(r.setModem(RF69_MODEM_DEFAULT));
+  byte after[5] = { sim.regs[0x03], sim.regs[0x04], sim.regs[0x19], sim.regs[0x1A], sim.regs[0x3D] };
+  assert(!memcmp(before, after, 3) && after[4] == before[4]);
+
+  for (byte p = 1; p < RF69_MODEM_PROFILES; p++)
+  {
+    assert(r.setModem(p));
+    unsigned long br = r.getBitrate();
+    unsigned long fdev = ((sim.regs[0x05] << 8) | sim.regs[0x06]) * 61UL;
+    printf("profile %d: %6lu bps, FDEV %6lu Hz, RXBW %02x, AFCBW %02x, RX restart delay %2d, 20 byte frame %6lu us\n",
+      p, br, fdev, sim.regs[0x19], sim.regs[0x1A], sim.regs[0x3D] >> 4, r.getAirtime(20));
+    assert(fdev + br / 2 <= 500000 && fdev * 4 >= br); //modulation index 2 * FDEV / BR >= 0.5
+  }
+  printf("20 byte frame: %lu us at the default rate, %lu us at 300kbps\n", base, r.getAirtime(20));
+  assert(base > 80000 && r.getAirtime(20) < 1000);
+
+  byte kept[2] = { sim.regs[0x03], sim.regs[0x04] };
+  assert(!r.setModem(RF69_MODEM_PROFILES));
+  assert(!r.setModem(300000, 400000)); //FDEV + BR/2 over 500kHz
+  assert(!r.setModem(100000, 10000)); //modulation index under 0.5
+  assert(!r.setModem(100000, 50000, 40000)); //channel filter narrower than BR/2
+  assert(sim.regs[0x03] == kept[0] && sim.regs[0x04] == kept[1]);
+  assert(r.setModem(50000, 25000, 60000));
+  puts("ok");
+  return 0;
+}
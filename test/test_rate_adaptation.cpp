@@ -0,0 +1,79 @@
+// Rate adaptation against a destination whose delivery ratio falls off above 55.5kbps: the
+// sender learns the profile with the best goodput, agrees every switch with the destination in
+// band, gives up rather than wait while the destination may be held off the base, and both sides
+// are back on the base profile once the link goes quiet
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+#include <stdlib.h>
+
+static const double DELIVERY[RF69_MODEM_PROFILES] = { 1, 1, 1, 1, 1, 1, 0.6, 0.1, 0 };
+static const word BITRATE_REG[RF69_MODEM_PROFILES] = { 0x2E66, 0x1A0B, 0x0D05, 0x0683, 0x0341, 0x0240, 0x0140, 0x00A0, 0x006B };
+static int rxProfile = RF69_MODEM_4K8; //the destination's receiver
+static uint32_t rxLast;
+static int sentAt[RF69_MODEM_PROFILES];
+static int lost;
+
+static int profile() {
+  word br = (sim.regs[0x03] << 8) | sim.regs[0x04];
+  for (int i = 0; i < RF69_MODEM_PROFILES; i++)
+    if (BITRATE_REG[i] == br)
+      return i;
+  return -1;
+}
+
+//node 5, in interrupt context right after PacketSent: hears the frame only on its own profile
+static void onSent() {
+  byte ctl = sim.tx[3];
+  if (!(ctl & RF69_CTL_REQACK))
+    return;
+  int at = profile();
+  assert(at >= 0);
+  sentAt[at]++;
+  if (g_ms - rxLast > RF69_RATE_HOLD)
+    rxProfile = RF69_MODEM_4K8;
+  if (at != rxProfile || drand48() >= DELIVERY[at])
+  {
+    lost++;
+    return;
+  }
+  rxLast = g_ms;
+  if ((ctl & RF69_CTL_EXT) && (sim.tx[4] & RF69_EXT_TYPE) == RF69_EXT_RATE)
+    rxProfile = sim.tx[5]; //the ACK goes out on the new profile
+  if (drand48() >= DELIVERY[rxProfile])
+    return;
+  byte ack[3] = { 1, 5, (byte)(RF69_CTL_SENDACK | (ctl & RF69_CTL_SEQ)) };
+  sim.inject(ack, 3);
+}
+
+int main() {
+  srand48(1);
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  assert(r.setModem(RF69_MODEM_4K8) && r.setRateAdaptation(true));
+  sim.onSent = onSent;
+  int delivered = 0, retried = 0;
+  for (int i = 0; i < 600; i++)
+  {
+    if (i == 300)
+      memset(sentAt, 0, sizeof(sentAt));
+    if (r.sendWithRetry(5, "0123456789", 10))
+      delivered++;
+    else
+    {
+      g_ms += RF69_RATE_HOLD; //the sketch tries again later, by then the destination is back on the base
+      retried += r.sendWithRetry(5, "0123456789", 10);
+    }
+  }
+  int total = 0;
+  for (int i = 0; i < RF69_MODEM_PROFILES; i++)
+    total += sentAt[i];
+  printf("delivered %d/600 + %d on a later try, %d of the last %d transmissions at 55.5kbps\n", delivered, retried, sentAt[RF69_MODEM_55K5], total);
+  assert(delivered >= 570 && delivered + retried >= 595 && sentAt[RF69_MODEM_55K5] * 2 > total);
+
+  g_ms += 1000;
+  r.receiveDone();
+  assert(profile() == RF69_MODEM_4K8);
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Receive queue (RF69_RX_QUEUE_SIZE slots filled by the ISR): frames come out in the order they
+// arrived, a full queue drops and counts new frames, and an ISR landing while receiveDone() or a
+// receive callback works on the oldest slot never touches that slot
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+static void frame(byte sender, byte ctl, char payload, byte* f) {
+  f[0] = 1; //our node ID
+  f[1] = sender;
+  f[2] = ctl;
+  f[3] = payload;
+}
+
+static void inject(byte sender, byte ctl, char payload) {
+  byte f[4];
+  frame(sender, ctl, payload, f);
+  sim.inject(f, 4);
+}
+
+static RFM69* radio;
+static int callbacks;
+static void onFrame(const RFM69Frame& f) {
+  char before = f.data[0];
+  byte sender = f.senderID;
+  if (callbacks++ == 0)
+    inject(50, 0, 'z'); //preempts the callback, the queue is full
+  assert(f.data[0] == before && f.senderID == sender);
+}
+
+int main() {
+  RFM69 r;
+  radio = &r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  r.receiveDone();
+
+  //ordering
+  for (int i = 0; i < 3; i++)
+    inject(10 + i, 0, 'a' + i);
+  assert(r.framesPending() == 3);
+  for (int i = 0; i < 3; i++)
+  {
+    assert(r.receiveDone());
+    assert(r.SENDERID == 10 + i && r.DATALEN == 1 && r.DATA[0] == 'a' + i);
+  }
+  assert(!r.receiveDone());
+
+  //overflow: the first RF69_RX_QUEUE_SIZE stay, the rest are counted
+  for (int i = 0; i < RF69_RX_QUEUE_SIZE + 2; i++)
+    inject(20 + i, 0, 'A' + i);
+  assert(r.framesPending() == RF69_RX_QUEUE_SIZE);
+  assert(r.getRxOverflows() == 2);
+  for (int i = 0; i < RF69_RX_QUEUE_SIZE; i++)
+    assert(r.receiveDone() && r.SENDERID == 20 + i && r.DATA[0] == 'A' + i);
+  assert(!r.receiveDone());
+  inject(30, 0, 'q');
+  assert(r.receiveDone() && r.SENDERID == 30 && r.DATA[0] == 'q');
+
+  //a frame arriving inside receiveDone()'s critical section waits its turn
+  inject(31, 0, 'r');
+  byte f[4];
+  frame(32, 0, 's', f);
+  sim.injectInCritical(f, 4);
+  assert(r.receiveDone() && r.SENDERID == 31 && r.DATA[0] == 'r');
+  assert(r.framesPending() == 1);
+  assert(r.receiveDone() && r.SENDERID == 32 && r.DATA[0] == 's');
+
+  //ACKReceived() takes the ACK out of the middle of the queue and leaves the rest
+  inject(40, RF69_CTL_REQACK, 'x');
+  inject(41, RF69_CTL_SENDACK, 'y');
+  inject(42, 0, 'w');
+  assert(r.ACKReceived(41) && r.SENDERID == 41);
+  assert(r.receiveDone() && r.SENDERID == 40 && r.ACK_REQUESTED);
+  assert(r.receiveDone() && r.SENDERID == 42);
+
+  //with a receive buffer, payloads go there but an ACK's stays in DATA
+  char buffer[4] = "";
+  r.setReceiveBuffer(buffer, sizeof(buffer));
+  inject(43, RF69_CTL_SENDACK, 'v');
+  inject(44, 0, 'u');
+  assert(r.ACKReceived(43) && r.DATA[0] == 'v' && buffer[0] == 0);
+  assert(r.receiveDone() && r.SENDERID == 44 && buffer[0] == 'u');
+  r.setReceiveBuffer(null, 0);
+
+  //the slot a callback is working on stays put while the ISR queues behind it
+  for (int i = 0; i < RF69_RX_QUEUE_SIZE; i++)
+    inject(60 + i, 0, 'k' + i);
+  word overflows = r.getRxOverflows();
+  r.setReceiveCallback(onFrame);
+  while (r.receiveDone());
+  assert(callbacks == RF69_RX_QUEUE_SIZE);
+  assert(r.getRxOverflows() == overflows + 1);
+
+  puts("ok");
+  return 0;
+}
@@ -0,0 +1,37 @@
+// SPI cost of the common paths, as counted by getSpiTransactions() (chip select cycles):
+// the register mirror saves the read half of read-modify-writes, burst access sends whole
+// register runs in one cycle
+#include "sim.h"
+#include <RFM69.h>
+#include <assert.h>
+
+int main() {
+  RFM69 r;
+  r.initialize(RF69_433MHZ, 1, 100);
+  unsigned long init = r.getSpiTransactions();
+  r.receiveDone();
+
+  //send and its PacketSent interrupt
+  unsigned long start = r.getSpiTransactions();
+  assert(r.startSend(2, "hello", 5, false));
+  sim.waitTx();
+  unsigned long send = r.getSpiTransactions() - start;
+
+  //back to RX, a frame comes in and is read
+  start = r.getSpiTransactions();
+  r.receiveDone();
+  byte f[4] = { 1, 2, 0, 'x' };
+  sim.inject(f, 4);
+  assert(r.receiveDone() && r.DATA[0] == 'x');
+  unsigned long receive = r.getSpiTransactions() - start;
+
+  byte regs[RF69_REG_SNAPSHOT_SIZE];
+  start = r.getSpiTransactions();
+  r.snapshotRegs(regs);
+  unsigned long dump = r.getSpiTransactions() - start;
+
+  printf("initialize %lu, send %lu, receive %lu, register dump %lu\n", init, send, receive, dump);
+  assert(init <= 15 && send <= 9 && receive <= 6 && dump == 1);
+  puts("ok");
+  return 0;
+}